@@ -0,0 +1,801 @@
+#include <edat.h>
+#include <parsers.h>
+#include <generator.h>
+#include <alloc_stats.h>
+#include <table_pool.h>
+#include <table_array.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#ifdef __linux__
+#include <malloc.h>
+#include <sched.h>
+#endif
+#ifdef __GNUC__
+#include <cxxabi.h>
+#endif
+
+// Microbenchmarks for the core operations, results are printed as JSON.
+// Usage: edat_bench [--scale N] [--filter substring] [--repeat N] [--warmup N] [--pin CPU] [--out results.json]
+//   --scale multiplies the input sizes (1 by default, fixed inputs), so the same suite covers
+//   small configs and scaling limits.
+//   --repeat runs the whole suite N times (1) and reports the median with its standard deviation,
+//   after --warmup discarded runs (0). --pin keeps the process on one CPU to cut down the noise.
+// compare.py checks the results against bench/baseline.json, see the bench-check target.
+// Built with -DEDAT_ALLOC_STATS=ON it also reports allocations per call of the main API (alloc_* entries)
+// and fails if one of them goes over its budget (allocBudgets).
+// memory_* entries are peak RSS of parseFile and Table::memoryBytes relative to the input size (Linux only),
+// the first run also prints where that memory goes.
+
+namespace fs = std::filesystem;
+
+struct BenchResult
+{
+    std::string name;
+    std::string unit;
+    bool higherIsBetter = false;
+    double value = 0.0;
+    size_t iterations = 0;
+    double stddev = 0.0; // of the value over the repeated runs
+    size_t samples = 1;
+};
+
+struct BenchContext
+{
+    size_t scale = 1;
+    std::string filter;
+    std::vector<BenchResult> results;
+    bool firstRun = true; // for one-off diagnostics on stderr
+
+    bool enabled(const std::string& name) const
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    // Results of a single run, see aggregateRuns
+    void report(BenchResult res)
+    {
+        results.push_back(std::move(res));
+    }
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Keeps the optimizer from throwing away results
+static volatile size_t sink = 0;
+
+static void consume(size_t val)
+{
+    sink = sink + val;
+}
+
+static void setupParsers(edat::ParserSuite& psuite)
+{
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        return std::stoi(std::string(str));
+    });
+    psuite.addLambdaParser<float>("float", [](const std::string_view& str) -> float
+    {
+        return std::stof(std::string(str));
+    });
+    psuite.addLambdaParser<std::string>("str", [](const std::string_view& str) -> std::string
+    {
+        return std::string(str);
+    });
+}
+
+// Generated document with scalars, arrays and nested tables, about 256KB per unit of scale.
+// With `inherited` sibling tables form `<-` chains.
+static std::string makeDocument(size_t scale, bool inherited)
+{
+    edat::GeneratorConfig config;
+    config.seed = 42;
+    config.targetBytes = uint64_t(256 * 1024) * scale;
+    config.inheritanceChain = inherited ? 4 : 0;
+    return edat::generateString(config);
+}
+
+static edat::Table makeFlatTable(size_t count)
+{
+    edat::Table tbl;
+    for (size_t i = 0; i < count; ++i)
+        tbl.set("key_" + std::to_string(i), float(i));
+    return tbl;
+}
+
+// Repeats `fn` until it has run for at least `minSeconds`, returns seconds per call
+static double timeRepeated(const std::function<void()>& fn, size_t& iterations, double minSeconds = 0.2)
+{
+    iterations = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    do
+    {
+        fn();
+        iterations++;
+        elapsed = secondsSince(start);
+    } while (elapsed < minSeconds);
+    return elapsed / double(iterations);
+}
+
+static void benchParse(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    const std::string doc = makeDocument(ctx.scale, false);
+    const double megabytes = double(doc.size()) / (1024.0 * 1024.0);
+
+    if (ctx.enabled("parse_string"))
+    {
+        BenchResult res{"parse_string", "MB/s", true};
+        double seconds = timeRepeated([&]() { consume(edat::parseString(doc, psuite).shape->names.size()); }, res.iterations);
+        res.value = megabytes / seconds;
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("parse_file"))
+    {
+        fs::path path = fs::temp_directory_path() / "edat_bench.edat";
+        FILE* f = fopen(path.string().c_str(), "wb");
+        fwrite(doc.data(), 1, doc.size(), f);
+        fclose(f);
+
+        BenchResult res{"parse_file", "MB/s", true};
+        double seconds = timeRepeated([&]() { consume(edat::parseFile(path, psuite).shape->names.size()); }, res.iterations);
+        res.value = megabytes / seconds;
+        ctx.report(res);
+        fs::remove(path);
+    }
+}
+
+static void benchLookups(BenchContext& ctx)
+{
+    const size_t keyCount = 10000 * ctx.scale;
+    const edat::Table tbl = makeFlatTable(keyCount);
+    std::vector<std::string> hits, misses;
+    for (size_t i = 0; i < 1024; ++i)
+    {
+        hits.push_back("key_" + std::to_string((i * 7919) % keyCount));
+        misses.push_back("missing_" + std::to_string(i));
+    }
+
+    if (ctx.enabled("getor_hit"))
+    {
+        BenchResult res{"getor_hit", "ns/op", false};
+        double seconds = timeRepeated([&]()
+        {
+            for (const std::string& key : hits)
+                consume(size_t(tbl.getOr<float>(key, 0.f)));
+        }, res.iterations);
+        res.value = seconds * 1e9 / double(hits.size());
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("getor_miss"))
+    {
+        BenchResult res{"getor_miss", "ns/op", false};
+        double seconds = timeRepeated([&]()
+        {
+            for (const std::string& key : misses)
+                consume(size_t(tbl.getOr<float>(key, 1.f)));
+        }, res.iterations);
+        res.value = seconds * 1e9 / double(misses.size());
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("getall_iterate"))
+    {
+        BenchResult res{"getall_iterate", "ns/elem", false};
+        double seconds = timeRepeated([&]()
+        {
+            float total = 0.f;
+            tbl.getAll<float>([&](const std::string&, float val) { total += val; });
+            consume(size_t(total));
+        }, res.iterations);
+        res.value = seconds * 1e9 / double(keyCount);
+        ctx.report(res);
+    }
+}
+
+static void benchSet(BenchContext& ctx)
+{
+    if (!ctx.enabled("set_insert"))
+        return;
+    const size_t keyCount = 10000 * ctx.scale;
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < keyCount; ++i)
+        keys.push_back("key_" + std::to_string(i));
+
+    BenchResult res{"set_insert", "Mops/s", true};
+    double seconds = timeRepeated([&]()
+    {
+        edat::Table tbl;
+        for (const std::string& key : keys)
+            tbl.set(key, 1.f);
+        consume(tbl.shape->names.size());
+    }, res.iterations);
+    res.value = double(keyCount) / seconds * 1e-6;
+    ctx.report(res);
+}
+
+// Per-request scratch table: fill, read, drop. Names are long enough not to fit the small string buffer.
+static std::vector<std::string> makeScratchKeys()
+{
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < 64; ++i)
+        keys.push_back("request_field_" + std::to_string(i) + "_value");
+    return keys;
+}
+
+static void fillScratch(edat::Table& tbl, const std::vector<std::string>& keys)
+{
+    for (size_t i = 0; i < keys.size(); ++i)
+        tbl.set(keys[i], float(i));
+    float total = 0.f;
+    for (const std::string& key : keys)
+        total += tbl.getOr<float>(key, 0.f);
+    consume(size_t(total));
+}
+
+static void benchScratch(BenchContext& ctx)
+{
+    const std::vector<std::string> keys = makeScratchKeys();
+    if (ctx.enabled("scratch_fresh"))
+    {
+        BenchResult res{"scratch_fresh", "us/op", false};
+        double seconds = timeRepeated([&]()
+        {
+            edat::Table tbl;
+            fillScratch(tbl, keys);
+        }, res.iterations);
+        res.value = seconds * 1e6;
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("scratch_pooled"))
+    {
+        edat::TablePool pool(1);
+        BenchResult res{"scratch_pooled", "us/op", false};
+        double seconds = timeRepeated([&]()
+        {
+            edat::TablePool::Lease tbl = pool.acquire();
+            fillScratch(*tbl, keys);
+        }, res.iterations);
+        res.value = seconds * 1e6;
+        ctx.report(res);
+    }
+}
+
+static void benchClone(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    if (ctx.enabled("clone_table"))
+    {
+        const edat::Table tbl = edat::parseString(makeDocument(ctx.scale, false), psuite);
+        BenchResult res{"clone_table", "us/op", false};
+        double seconds = timeRepeated([&]() { consume(edat::cloneTable(tbl).shape->names.size()); }, res.iterations);
+        res.value = seconds * 1e6;
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("parse_inherited"))
+    {
+        // Same document with every subtable inheriting from the previous one, the difference to
+        // parse_string is the cost of `<-`
+        const std::string doc = makeDocument(ctx.scale, true);
+        BenchResult res{"parse_inherited", "MB/s", true};
+        double seconds = timeRepeated([&]() { consume(edat::parseString(doc, psuite).shape->names.size()); }, res.iterations);
+        res.value = double(doc.size()) / (1024.0 * 1024.0) / seconds;
+        ctx.report(res);
+    }
+}
+
+// Array of tables with the same keys, stored column-wise
+static void benchTableArray(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    if (!ctx.enabled("table_array_parse") && !ctx.enabled("table_array_column"))
+        return;
+    const size_t count = 10000 * ctx.scale;
+    std::string doc = "items:table[] = [\n";
+    for (size_t i = 0; i < count; ++i)
+        doc += "  { id:int = \"" + std::to_string(i) + "\"; weight:float = \"1.5\"; name:str = \"item\" }\n";
+    doc += "]\n";
+
+    if (ctx.enabled("table_array_parse"))
+    {
+        BenchResult res{"table_array_parse", "MB/s", true};
+        double seconds = timeRepeated([&]() { consume(edat::parseString(doc, psuite).shape->names.size()); }, res.iterations);
+        res.value = double(doc.size()) / (1024.0 * 1024.0) / seconds;
+        ctx.report(res);
+    }
+
+    if (ctx.enabled("table_array_column"))
+    {
+        const edat::Table tbl = edat::parseString(doc, psuite);
+        BenchResult res{"table_array_column", "ns/elem", false};
+        double seconds = timeRepeated([&]()
+        {
+            tbl.get<edat::TableArray>("items", [&](const edat::TableArray& items)
+            {
+                float total = 0.f;
+                for (float weight : items.column<float>("weight"))
+                    total += weight;
+                consume(size_t(total));
+            });
+        }, res.iterations);
+        res.value = seconds * 1e9 / double(count);
+        ctx.report(res);
+    }
+}
+
+// Bulk queries over the packed bools of a feature flag table
+static void benchFlags(BenchContext& ctx)
+{
+    if (!ctx.enabled("flags_popcount"))
+        return;
+    const size_t count = 100000 * ctx.scale;
+    edat::Table tbl;
+    for (size_t i = 0; i < count; ++i)
+        tbl.set("flag_" + std::to_string(i), i % 3 == 0);
+    BenchResult res{"flags_popcount", "ns/elem", false};
+    double seconds = timeRepeated([&]() { consume(tbl.view<bool>().values->popcount()); }, res.iterations);
+    res.value = seconds * 1e9 / double(count);
+    ctx.report(res);
+}
+
+static void benchEnums(BenchContext& ctx)
+{
+    if (!ctx.enabled("enum_parse"))
+        return;
+    enum class Mode : uint8_t { Off, On, Auto, Low, Medium, High, Ultra, Custom };
+    const edat::EnumParser<Mode> parser("mode", std::initializer_list<std::pair<std::string_view, Mode>>{
+        {"off", Mode::Off}, {"on", Mode::On}, {"auto", Mode::Auto}, {"low", Mode::Low},
+        {"medium", Mode::Medium}, {"high", Mode::High}, {"ultra", Mode::Ultra}, {"custom", Mode::Custom}});
+    const size_t count = 100000 * ctx.scale;
+    std::vector<std::string_view> strings;
+    strings.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+        strings.push_back(parser.names[(i * 7) % parser.names.size()]);
+    BenchResult res{"enum_parse", "ns/elem", false};
+    double seconds = timeRepeated([&]()
+    {
+        size_t sum = 0;
+        for (const std::string_view& str : strings)
+            sum += (size_t)parser.parse(str);
+        consume(sum);
+    }, res.iterations);
+    res.value = seconds * 1e9 / double(count);
+    ctx.report(res);
+}
+
+static void benchTeardown(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    if (!ctx.enabled("table_teardown"))
+        return;
+    const edat::Table tbl = edat::parseString(makeDocument(ctx.scale, false), psuite);
+    BenchResult res{"table_teardown", "us/op", false};
+    double total = 0.0;
+    Clock::time_point start = Clock::now();
+    do
+    {
+        edat::Table* copy = new edat::Table(edat::cloneTable(tbl));
+        Clock::time_point destroyStart = Clock::now();
+        delete copy;
+        total += secondsSince(destroyStart);
+        res.iterations++;
+    } while (secondsSince(start) < 0.2);
+    res.value = total / double(res.iterations) * 1e6;
+    ctx.report(res);
+}
+
+// Three entries per API call: allocation count, requested bytes and peak live bytes, each per op
+static void reportAllocations(BenchContext& ctx, const std::string& name, const edat::AllocStats& stats, size_t ops)
+{
+    const double div = double(ops);
+    ctx.report({"alloc_" + name + "_count", "allocs/op", false, double(stats.count) / div, ops});
+    ctx.report({"alloc_" + name + "_bytes", "bytes/op", false, double(stats.bytes) / div, ops});
+    ctx.report({"alloc_" + name + "_peak", "bytes", false, double(stats.peakLiveBytes), ops});
+}
+
+// Upper limits for the alloc_* entries, checked after the runs: edat_bench exits with 1 if one is exceeded.
+// Lookups and a warmed up pool must not allocate at all, set only grows the storage and the name index.
+struct AllocBudget
+{
+    const char* name;
+    double maxValue;
+};
+
+static constexpr AllocBudget allocBudgets[] = {
+    {"alloc_getor_count", 0.0},
+    {"alloc_getor_bytes", 0.0},
+    {"alloc_scratch_pooled_count", 0.0},
+    {"alloc_scratch_pooled_bytes", 0.0},
+    {"alloc_set_count", 2.0},
+};
+
+// Prints every exceeded budget, returns false if there was one
+static bool checkAllocBudgets(const std::vector<BenchResult>& results)
+{
+    bool res = true;
+    for (const AllocBudget& budget : allocBudgets)
+        for (const BenchResult& result : results)
+            if (result.name == budget.name && result.value > budget.maxValue)
+            {
+                fprintf(stderr, "Error: %s is %.3f %s, over the budget of %.3f\n", budget.name, result.value,
+                        result.unit.c_str(), budget.maxValue);
+                res = false;
+            }
+    return res;
+}
+
+static void benchAllocations(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    if (!edat::allocStatsEnabled)
+        return;
+
+    const std::string doc = makeDocument(ctx.scale, false);
+    if (ctx.enabled("alloc_parse_file"))
+    {
+        fs::path path = fs::temp_directory_path() / "edat_bench_alloc.edat";
+        FILE* f = fopen(path.string().c_str(), "wb");
+        fwrite(doc.data(), 1, doc.size(), f);
+        fclose(f);
+        edat::AllocStats stats = edat::measureAllocations([&]() { consume(edat::parseFile(path, psuite).shape->names.size()); });
+        reportAllocations(ctx, "parse_file", stats, 1);
+        fs::remove(path);
+    }
+
+    const size_t keyCount = 10000 * ctx.scale;
+    const edat::Table flat = makeFlatTable(keyCount);
+    if (ctx.enabled("alloc_getor"))
+    {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < 1024; ++i)
+            keys.push_back(i % 2 ? "key_" + std::to_string((i * 7919) % keyCount) : "missing_" + std::to_string(i));
+        edat::AllocStats stats = edat::measureAllocations([&]()
+        {
+            for (const std::string& key : keys)
+                consume(size_t(flat.getOr<float>(key, 0.f)));
+        });
+        reportAllocations(ctx, "getor", stats, keys.size());
+    }
+
+    if (ctx.enabled("alloc_set"))
+    {
+        std::vector<std::string> keys;
+        for (size_t i = 0; i < keyCount; ++i)
+            keys.push_back("key_" + std::to_string(i));
+        edat::AllocStats stats = edat::measureAllocations([&]()
+        {
+            edat::Table tbl;
+            for (const std::string& key : keys)
+                tbl.set(key, 1.f);
+            consume(tbl.shape->names.size());
+        });
+        reportAllocations(ctx, "set", stats, keys.size());
+    }
+
+    if (ctx.enabled("alloc_scratch_pooled"))
+    {
+        // Steady state: the pool has seen the same kind of request before
+        const std::vector<std::string> keys = makeScratchKeys();
+        edat::TablePool pool(1);
+        for (int i = 0; i < 2; ++i)
+            fillScratch(*pool.acquire(), keys);
+        edat::AllocStats stats = edat::measureAllocations([&]() { fillScratch(*pool.acquire(), keys); });
+        reportAllocations(ctx, "scratch_pooled", stats, 1);
+    }
+
+    if (ctx.enabled("alloc_clone_table"))
+    {
+        const edat::Table tbl = edat::parseString(doc, psuite);
+        edat::AllocStats stats = edat::measureAllocations([&]() { consume(edat::cloneTable(tbl).shape->names.size()); });
+        reportAllocations(ctx, "clone_table", stats, 1);
+    }
+}
+
+#ifdef __linux__
+// Field of /proc/self/status in bytes, 0 if it can't be read
+static size_t readProcStatus(const char* field)
+{
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f)
+        return 0;
+    char line[256];
+    size_t res = 0;
+    const size_t fieldLen = strlen(field);
+    while (fgets(line, sizeof(line), f))
+        if (!strncmp(line, field, fieldLen) && line[fieldLen] == ':')
+            res = size_t(strtoull(line + fieldLen + 1, nullptr, 10)) * 1024;
+    fclose(f);
+    return res;
+}
+
+// Resets VmHWM to the current RSS, Linux 4.0+
+static bool resetPeakRss()
+{
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (!f)
+        return false;
+    const bool ok = fputs("5", f) >= 0;
+    return fclose(f) == 0 && ok;
+}
+#endif
+
+static std::string typeName(const std::type_info& type)
+{
+#ifdef __GNUC__
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+    if (status == 0 && demangled)
+    {
+        std::string res = demangled;
+        free(demangled);
+        // Spell the standard types the short way
+        const std::string longString = "std::__cxx11::basic_string<char, std::char_traits<char>, std::allocator<char> >";
+        for (size_t pos; (pos = res.find(longString)) != std::string::npos;)
+            res.replace(pos, longString.size(), "std::string");
+        for (size_t pos; (pos = res.find(", std::allocator<")) != std::string::npos;)
+        {
+            size_t end = pos + 17;
+            for (int depth = 1; end < res.size() && depth > 0; ++end)
+                depth += res[end] == '<' ? 1 : res[end] == '>' ? -1 : 0;
+            if (end < res.size() && res[end] == ' ')
+                end++;
+            res.erase(pos, end - pos);
+        }
+        return res;
+    }
+#endif
+    return type.name();
+}
+
+// Sums up the usage of all the nested tables into one, per type entries are merged by type
+static void accumulateUsage(const edat::MemoryUsage& usage, edat::MemoryUsage& sum)
+{
+    sum.names += usage.names;
+    sum.records += usage.records;
+    sum.nameMap += usage.nameMap;
+    sum.typeHashMap += usage.typeHashMap;
+    sum.storageList += usage.storageList;
+    for (const edat::MemoryUsage::TypeUsage& type : usage.types)
+    {
+        auto itf = std::find_if(sum.types.begin(), sum.types.end(), [&](const edat::MemoryUsage::TypeUsage& t) { return *t.type == *type.type; });
+        if (itf == sum.types.end())
+            sum.types.push_back(type);
+        else
+            itf->bytes += type.bytes;
+    }
+    for (const edat::MemoryUsage::SubTableUsage& sub : usage.subTables)
+        accumulateUsage(sub.usage, sum);
+}
+
+static void printUsage(const edat::MemoryUsage& usage, double inputBytes)
+{
+    auto line = [&](const std::string& what, size_t bytes)
+    {
+        fprintf(stderr, "  %-40s %12zu bytes %6.2fx input\n", what.c_str(), bytes, double(bytes) / inputBytes);
+    };
+    line("names", usage.names);
+    line("records", usage.records);
+    line("nameMap", usage.nameMap);
+    line("typeHashMap", usage.typeHashMap);
+    line("storage list", usage.storageList);
+    for (const edat::MemoryUsage::TypeUsage& type : usage.types)
+        line(typeName(*type.type), type.bytes);
+}
+
+// Peak RSS while loading a file relative to the file size, together with what the table itself accounts for
+static void benchMemory(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+#ifdef __linux__
+    if (!ctx.enabled("memory_parse_file"))
+        return;
+    const std::string doc = makeDocument(ctx.scale, false);
+    fs::path path = fs::temp_directory_path() / "edat_bench_memory.edat";
+    FILE* f = fopen(path.string().c_str(), "wb");
+    fwrite(doc.data(), 1, doc.size(), f);
+    fclose(f);
+
+    // Hand freed memory of the earlier benchmarks back, it would hide the growth otherwise
+    malloc_trim(0);
+    if (!resetPeakRss())
+    {
+        fprintf(stderr, "Warning: can't reset peak RSS, skipping memory_parse_file\n");
+        fs::remove(path);
+        return;
+    }
+    const size_t rssBefore = readProcStatus("VmRSS");
+    edat::Table tbl = edat::parseFile(path, psuite);
+    const size_t peak = readProcStatus("VmHWM");
+    fs::remove(path);
+
+    const double inputBytes = double(doc.size());
+    ctx.report({"memory_parse_file", "x input", false, double(peak > rssBefore ? peak - rssBefore : 0) / inputBytes, 1});
+    ctx.report({"memory_table", "x input", false, double(tbl.memoryBytes()) / inputBytes, 1});
+
+    if (ctx.firstRun)
+    {
+        edat::MemoryUsage sum;
+        accumulateUsage(tbl.memoryUsage(), sum);
+        fprintf(stderr, "Memory of a %zu byte document, all nested tables together:\n", doc.size());
+        printUsage(sum, inputBytes);
+    }
+#endif
+}
+
+static void runSuite(BenchContext& ctx, const edat::ParserSuite& psuite)
+{
+    benchParse(ctx, psuite);
+    benchLookups(ctx);
+    benchSet(ctx);
+    benchScratch(ctx);
+    benchClone(ctx, psuite);
+    benchTeardown(ctx, psuite);
+    benchTableArray(ctx, psuite);
+    benchFlags(ctx);
+    benchEnums(ctx);
+    benchAllocations(ctx, psuite);
+    benchMemory(ctx, psuite);
+}
+
+// Median and standard deviation of every benchmark over the runs, runs are expected to have the same benchmarks in the same order
+static std::vector<BenchResult> aggregateRuns(const std::vector<std::vector<BenchResult>>& runs)
+{
+    std::vector<BenchResult> res;
+    if (runs.empty())
+        return res;
+    for (size_t i = 0; i < runs[0].size(); ++i)
+    {
+        std::vector<double> values;
+        size_t iterations = 0;
+        for (const std::vector<BenchResult>& run : runs)
+        {
+            values.push_back(run[i].value);
+            iterations += run[i].iterations;
+        }
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        double mean = 0.0;
+        for (double v : values)
+            mean += v / double(n);
+        double variance = 0.0;
+        for (double v : values)
+            variance += (v - mean) * (v - mean);
+
+        BenchResult agg = runs[0][i];
+        agg.value = n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+        agg.stddev = n > 1 ? std::sqrt(variance / double(n - 1)) : 0.0;
+        agg.samples = n;
+        agg.iterations = iterations;
+        res.push_back(std::move(agg));
+    }
+    return res;
+}
+
+static bool pinToCpu(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+// CPU model and thread count, stored with the results: absolute times are only comparable on the same machine
+static std::string machineName()
+{
+    std::string model = "unknown";
+#ifdef __linux__
+    if (FILE* f = fopen("/proc/cpuinfo", "r"))
+    {
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            const char* colon = strchr(line, ':');
+            if (!strncmp(line, "model name", 10) && colon)
+            {
+                model = colon + 1 + strspn(colon + 1, " \t");
+                while (!model.empty() && (model.back() == '\n' || model.back() == '"' || model.back() == '\\'))
+                    model.pop_back();
+                break;
+            }
+        }
+        fclose(f);
+    }
+#endif
+    return model + ", " + std::to_string(std::thread::hardware_concurrency()) + " threads";
+}
+
+static void writeJson(FILE* f, const BenchContext& ctx)
+{
+#ifdef NDEBUG
+    const char* buildType = "optimized";
+#else
+    const char* buildType = "debug";
+#endif
+    fprintf(f, "{\n  \"scale\": %zu,\n  \"build\": \"%s\",\n  \"machine\": \"%s\",\n  \"benchmarks\": [\n", ctx.scale,
+            buildType, machineName().c_str());
+    for (size_t i = 0; i < ctx.results.size(); ++i)
+    {
+        const BenchResult& res = ctx.results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"unit\": \"%s\", \"higher_is_better\": %s, \"value\": %.6g, \"stddev\": %.6g, "
+                   "\"samples\": %zu, \"iterations\": %zu}%s\n",
+                res.name.c_str(), res.unit.c_str(), res.higherIsBetter ? "true" : "false", res.value, res.stddev,
+                res.samples, res.iterations, i + 1 < ctx.results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, const char** argv)
+{
+    BenchContext ctx;
+    const char* outPath = nullptr;
+    size_t repeat = 1;
+    size_t warmup = 0;
+    int pinCpu = -1;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--scale") && i + 1 < argc)
+            ctx.scale = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+            ctx.filter = argv[++i];
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc)
+            repeat = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--warmup") && i + 1 < argc)
+            warmup = std::max(0, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--pin") && i + 1 < argc)
+            pinCpu = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc)
+            outPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--scale N] [--filter substring] [--repeat N] [--warmup N] [--pin CPU] [--out results.json]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (pinCpu >= 0 && !pinToCpu(pinCpu))
+        fprintf(stderr, "Warning: can't pin to CPU %d, running unpinned\n", pinCpu);
+
+    edat::ParserSuite psuite;
+    setupParsers(psuite);
+
+    std::vector<std::vector<BenchResult>> runs;
+    for (size_t run = 0; run < warmup + repeat; ++run)
+    {
+        fprintf(stderr, run < warmup ? "warmup %zu/%zu\n" : "run %zu/%zu\n", run < warmup ? run + 1 : run - warmup + 1,
+                run < warmup ? warmup : repeat);
+        ctx.results.clear();
+        runSuite(ctx, psuite);
+        ctx.firstRun = false;
+        if (run >= warmup)
+            runs.push_back(std::move(ctx.results));
+    }
+    ctx.results = aggregateRuns(runs);
+    for (const BenchResult& res : ctx.results)
+        fprintf(stderr, "%-24s %12.3f %-10s +- %.3f\n", res.name.c_str(), res.value, res.unit.c_str(), res.stddev);
+
+    FILE* out = outPath ? fopen(outPath, "wb") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "Can't open '%s' for writing\n", outPath);
+        return 1;
+    }
+    writeJson(out, ctx);
+    if (outPath)
+        fclose(out);
+    return checkAllocBudgets(ctx.results) ? 0 : 1;
+}
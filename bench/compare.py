@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+"""Compares edat_bench results against a stored baseline, exits with 1 if anything regressed.
+
+Usage: compare.py baseline.json results.json [--threshold 0.1] [--sigmas 2] [--update]
+
+A benchmark regresses when it got worse than the baseline by more than `threshold` (relative)
+and the difference is also bigger than `sigmas` standard deviations of the two measurements combined,
+so noisy benchmarks don't fail the check on their own. A benchmark of the baseline that is missing from
+the results fails the check as well.
+Absolute times are only comparable on the machine the baseline was recorded on (its "machine" field).
+On another machine timings are compared as ratios: every timed benchmark is divided by the median change
+of all of them first, so only benchmarks that got slower relative to the rest of the suite regress.
+--update overwrites the baseline with the results instead of comparing.
+"""
+
+import argparse
+import json
+import math
+import shutil
+import statistics
+import sys
+
+# Units that depend on the speed of the machine, the others (allocations, memory) are compared as they are
+TIMED_UNITS = {"MB/s", "Mops/s", "ns/elem", "ns/op", "us/op"}
+
+
+def load(path):
+    with open(path) as f:
+        data = json.load(f)
+    return data, {bench["name"]: bench for bench in data["benchmarks"]}
+
+
+def slowdown(base, res):
+    """How many times worse the result is than the baseline, above 1 is slower"""
+    ratio = res["value"] / base["value"]
+    return 1 / ratio if res["higher_is_better"] else ratio
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check edat_bench results against a baseline")
+    parser.add_argument("baseline")
+    parser.add_argument("results")
+    parser.add_argument("--threshold", type=float, default=0.1, help="allowed relative slowdown (0.1 is 10%%)")
+    parser.add_argument("--sigmas", type=float, default=2.0, help="required significance in standard deviations")
+    parser.add_argument("--update", action="store_true", help="replace the baseline with the results")
+    args = parser.parse_args()
+
+    if args.update:
+        shutil.copyfile(args.results, args.baseline)
+        print(f"Baseline {args.baseline} updated")
+        return 0
+
+    baseline, baseBenches = load(args.baseline)
+    results, resBenches = load(args.results)
+    for key in ("scale", "build"):
+        if baseline.get(key) != results.get(key):
+            print(f"Warning: {key} differs from the baseline ({baseline.get(key)} vs {results.get(key)}), "
+                  "the comparison is likely meaningless")
+
+    # Machine speed factor, 1 on the machine of the baseline
+    speed = 1.0
+    relative = baseline.get("machine") != results.get("machine")
+    if relative:
+        ratios = [slowdown(baseBenches[name], res) for name, res in resBenches.items()
+                  if name in baseBenches and res["unit"] in TIMED_UNITS and baseBenches[name]["value"] > 0
+                  and res["value"] > 0]
+        if ratios:
+            speed = statistics.median(ratios)
+        print(f"Baseline recorded on '{baseline.get('machine')}', running on '{results.get('machine')}': "
+              f"comparing timings relative to the median change ({speed:.3g}x)")
+
+    regressions = []
+    print(f"{'benchmark':<26} {'baseline':>12} {'current':>12} {'change':>8}")
+    for name, res in resBenches.items():
+        base = baseBenches.get(name)
+        if base is None:
+            print(f"{name:<26} {'-':>12} {res['value']:>12.4g}      new")
+            continue
+        baseValue = base["value"]
+        value = res["value"]
+        if baseValue == 0:
+            # Budgets like "no allocations", anything above zero is a regression for lower-is-better
+            worse = value > 0 and not res["higher_is_better"]
+        else:
+            change = (value - baseValue) / abs(baseValue)
+            if res["higher_is_better"]:
+                change = -change
+            noise = math.hypot(base.get("stddev", 0.0), res.get("stddev", 0.0))
+            worse = change > args.threshold and abs(value - baseValue) > args.sigmas * noise
+            if res["unit"] in TIMED_UNITS and relative and value > 0:
+                change = slowdown(base, res) / speed - 1
+                relNoise = math.hypot(base.get("stddev", 0.0) / baseValue, res.get("stddev", 0.0) / value)
+                worse = change > args.threshold and change > args.sigmas * relNoise
+        mark = "  REGRESSION" if worse else ""
+        delta = (value - baseValue) / abs(baseValue) * 100 if baseValue != 0 else 0.0
+        print(f"{name:<26} {baseValue:>12.4g} {value:>12.4g} {delta:>+7.1f}%{mark}")
+        if worse:
+            regressions.append(name)
+
+    missing = [name for name in baseBenches if name not in resBenches]
+    for name in missing:
+        print(f"{name:<26} missing from the results")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) beyond {args.threshold * 100:.0f}%: {', '.join(regressions)}")
+    if missing:
+        print(f"\n{len(missing)} benchmark(s) of the baseline didn't run: {', '.join(missing)}")
+    if regressions or missing:
+        return 1
+    print("\nNo regressions")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,136 @@
+#include <edat.h>
+#include <parsers.h>
+#include <snapshot.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+// Measures how read throughput scales with the number of reader threads.
+// Usage: edat_scaling [maxThreads] [fileCount]
+
+static edat::Table makeTable(size_t count)
+{
+    edat::Table tbl;
+    for (size_t i = 0; i < count; ++i)
+    {
+        tbl.set("int_" + std::to_string(i), int(i));
+        tbl.set("float_" + std::to_string(i), float(i) * 0.5f);
+    }
+    return tbl;
+}
+
+static void benchSnapshotReads(size_t maxThreads)
+{
+    constexpr size_t keyCount = 1024;
+    constexpr size_t readsPerThread = 2'000'000;
+
+    edat::Snapshot snapshot(makeTable(keyCount));
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < keyCount; ++i)
+        keys.push_back("int_" + std::to_string(i));
+
+    printf("Snapshot getOr<int>, %zu reads per thread\n", readsPerThread);
+    double singleThreaded = 0.0;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        std::atomic<long long> checksum = 0;
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]()
+            {
+                // Every thread owns a copy, sharing is just a refcount
+                edat::Snapshot local = snapshot;
+                long long sum = 0;
+                for (size_t i = 0; i < readsPerThread; ++i)
+                    sum += local.getOr<int>(keys[(i + t * 7) % keyCount], 0);
+                checksum += sum;
+            });
+        }
+        for (std::thread& worker : workers)
+            worker.join();
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double readsPerSecond = double(threads * readsPerThread) / seconds;
+        if (threads == 1)
+            singleThreaded = readsPerSecond;
+        printf("\t%2zu threads: %8.2f Mreads/s (x%.2f) [checksum %lld]\n",
+               threads, readsPerSecond * 1e-6, readsPerSecond / singleThreaded, checksum.load());
+    }
+}
+
+static void writeTestFile(const std::filesystem::path& path, size_t blocks)
+{
+    FILE* f = fopen(path.string().c_str(), "wb");
+    for (size_t i = 0; i < blocks; ++i)
+    {
+        fprintf(f, "value_%zu:float = \"%zu.5\"\n", i, i);
+        fprintf(f, "block_%zu = {\n", i);
+        fprintf(f, "    inner_int:int = \"%zu\"\n", i);
+        fprintf(f, "    inner_string:str = \"Hello darkness my old friend\"\n");
+        fprintf(f, "    vec:float[3] = [ \"-12\", \"22.2\", \"11\" ]\n");
+        fprintf(f, "}\n");
+    }
+    fclose(f);
+}
+
+static void benchParseFiles(size_t maxThreads, size_t fileCount)
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        return std::stoi(std::string(str));
+    });
+    psuite.addLambdaParser<float>("float", [](const std::string_view& str) -> float
+    {
+        return std::stof(std::string(str));
+    });
+    psuite.addLambdaParser<std::string>("str", [](const std::string_view& str) -> std::string
+    {
+        return std::string(str);
+    });
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "edat_scaling";
+    std::filesystem::create_directories(dir);
+    std::vector<std::filesystem::path> paths;
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        paths.push_back(dir / ("file_" + std::to_string(i) + ".edat"));
+        // Uneven sizes on purpose, so stealing has something to do
+        writeTestFile(paths.back(), 100 + (i % 7) * 200);
+    }
+
+    printf("parseFiles, %zu files\n", fileCount);
+    double singleThreaded = 0.0;
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<edat::Table> tables = edat::parseFiles(paths, psuite, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1)
+            singleThreaded = seconds;
+        printf("\t%2zu threads: %8.2f ms (x%.2f) [%zu tables]\n",
+               threads, seconds * 1e3, singleThreaded / seconds, tables.size());
+    }
+
+    std::filesystem::remove_all(dir);
+}
+
+int main(int argc, const char** argv)
+{
+    size_t maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    if (argc > 1)
+        maxThreads = std::max(1, atoi(argv[1]));
+
+    size_t fileCount = 400;
+    if (argc > 2)
+        fileCount = std::max(1, atoi(argv[2]));
+
+    benchSnapshotReads(maxThreads);
+    benchParseFiles(maxThreads, fileCount);
+
+    return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <edat.h>
+#include <parsers.h>
+
+#include <charconv>
+
+// Parsers that never throw, so any input can be thrown at them
+inline void setupFuzzParsers(edat::ParserSuite& psuite)
+{
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    psuite.addLambdaParser<float>("float", [](const std::string_view& str) -> float
+    {
+        float res = 0.f;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    psuite.addLambdaParser<std::string>("str", [](const std::string_view& str) -> std::string
+    {
+        return std::string(str);
+    });
+    psuite.addLambdaParser<bool>("bool", edat::parseBool);
+    psuite.addEnum<int>("mode", {{"off", 0}, {"on", 1}, {"auto", 2}});
+}
+
+// Keys in the table and all of its subtables, the size of the parse output.
+// Inheritance can legitimately make the output much bigger than the input, so time budgets are
+// relative to input and output size together.
+inline size_t countEntries(const edat::Table& tbl)
+{
+    size_t res = tbl.shape->names.size();
+    edat::TypedView<edat::Table> subTables = tbl.view<edat::Table>();
+    for (const edat::Table& sub : subTables.values)
+        res += countEntries(sub);
+    return res;
+}
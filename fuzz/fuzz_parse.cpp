@@ -0,0 +1,53 @@
+#include "fuzz_common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// libFuzzer target for parseString. Besides crashes and sanitizer reports these count as failures:
+//  - a parse taking much longer than the size of its input and output warrants (super-linear behaviour),
+//    on top of libFuzzer's own -timeout for parses that never finish
+//  - IncrementalParser disagreeing with parseString
+// With clang: cmake -DEDAT_FUZZ=ON -DCMAKE_CXX_COMPILER=clang++ and `make fuzz`.
+// Any compiler builds edat_fuzz_replay, which runs the same checks over files (seed corpus, crash reproducers).
+
+static const edat::ParserSuite& fuzzParsers()
+{
+    static edat::ParserSuite psuite;
+    static bool initialized = false;
+    if (!initialized)
+    {
+        setupFuzzParsers(psuite);
+        initialized = true;
+    }
+    return psuite;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    const edat::ParserSuite& psuite = fuzzParsers();
+    const std::string input((const char*)data, size);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    edat::Table tbl = edat::parseString(input, psuite);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Generous enough for sanitizer builds, a linear parse is orders of magnitude below that
+    const size_t entries = countEntries(tbl);
+    const double budget = 0.05 + 2e-6 * double(size + entries);
+    if (seconds > budget)
+    {
+        fprintf(stderr, "Parsing %zu bytes into %zu entries took %.3fs, over the %.3fs budget\n", size, entries, seconds, budget);
+        abort();
+    }
+
+    edat::IncrementalParser incremental(input, psuite);
+    while (incremental.step(64))
+        ;
+    if (incremental.result.shape->names != tbl.shape->names)
+    {
+        fprintf(stderr, "IncrementalParser produced different keys than parseString\n");
+        abort();
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+#include "fuzz_common.h"
+#include <generator.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+
+// Checks that parse time grows linearly with the input: every input family is parsed at growing sizes
+// and the exponent of the time growth is estimated, anything notably above 1 fails the check.
+// Time is compared against input bytes plus output entries (see countEntries).
+// Usage: edat_linearity [--scale N] [--max-exponent E]
+//   --scale multiplies the input sizes (64KB..4MB by default), --max-exponent is 1.2 by default
+
+using Clock = std::chrono::steady_clock;
+
+struct Family
+{
+    const char* name;
+    std::function<std::string(size_t)> make; // document of roughly this many bytes
+};
+
+static std::string repeatUntil(std::string_view prefix, std::string_view item, std::string_view suffix, size_t bytes)
+{
+    std::string res(prefix);
+    while (res.size() + suffix.size() < bytes)
+        res += item;
+    res += suffix;
+    return res;
+}
+
+static std::vector<Family> makeFamilies()
+{
+    std::vector<Family> res;
+    res.push_back({"generated", [](size_t bytes)
+    {
+        edat::GeneratorConfig config;
+        config.seed = 7;
+        config.targetBytes = bytes;
+        return edat::generateString(config);
+    }});
+    res.push_back({"inherited", [](size_t bytes)
+    {
+        edat::GeneratorConfig config;
+        config.seed = 7;
+        config.targetBytes = bytes;
+        config.inheritanceChain = 8;
+        config.tableWeight = 4;
+        return edat::generateString(config);
+    }});
+    // Malformed inputs that end with an error after scanning everything
+    res.push_back({"unterminated_string", [](size_t bytes) { return repeatUntil("a:str = \"", "x", "", bytes); }});
+    res.push_back({"unterminated_array", [](size_t bytes) { return repeatUntil("a:int[] = [ ", "\"1\", ", "", bytes); }});
+    res.push_back({"unterminated_table", [](size_t bytes) { return repeatUntil("a = {\n", "x:int = \"1\"\n", "", bytes); }});
+    res.push_back({"long_line_error", [](size_t bytes) { return repeatUntil("a:int = \"1\"", " ", "!", bytes); }});
+    res.push_back({"long_name", [](size_t bytes) { return repeatUntil("", "n", ":int = \"1\"\n", bytes); }});
+    res.push_back({"empty_lines", [](size_t bytes) { return repeatUntil("", " \t\n", "a:int = \"1\"\n", bytes); }});
+    res.push_back({"unknown_types", [](size_t bytes) { return repeatUntil("", "a:nope = \"1\"\n", "", bytes); }});
+    res.push_back({"deep_tables", [](size_t bytes) { return repeatUntil("", "a = {\n", "", bytes); }});
+    return res;
+}
+
+int main(int argc, const char** argv)
+{
+    size_t scale = 1;
+    double maxExponent = 1.2;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "--scale") && i + 1 < argc)
+            scale = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--max-exponent") && i + 1 < argc)
+            maxExponent = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--scale N] [--max-exponent E]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // Parse errors are expected here and would flood the output
+    if (!freopen("/dev/null", "w", stdout))
+        fprintf(stderr, "Warning: can't silence stdout\n");
+
+    edat::ParserSuite psuite;
+    setupFuzzParsers(psuite);
+
+    bool failed = false;
+    for (const Family& family : makeFamilies())
+    {
+        double firstWork = 0.0, firstSeconds = 0.0, lastWork = 0.0, lastSeconds = 0.0;
+        for (size_t bytes = (64 << 10) * scale; bytes <= (4 << 20) * scale; bytes *= 4)
+        {
+            const std::string doc = family.make(bytes);
+            double best = 1e30;
+            size_t entries = 0;
+            for (int rep = 0; rep < 3; ++rep)
+            {
+                Clock::time_point start = Clock::now();
+                edat::Table tbl = edat::parseString(doc, psuite);
+                best = std::min(best, std::chrono::duration<double>(Clock::now() - start).count());
+                entries = countEntries(tbl);
+            }
+            const double work = double(doc.size() + entries);
+            if (firstWork == 0.0)
+            {
+                firstWork = work;
+                firstSeconds = best;
+            }
+            lastWork = work;
+            lastSeconds = best;
+            fprintf(stderr, "  %-20s %10zu bytes %10zu entries %10.3f ms\n", family.name, doc.size(), entries, best * 1e3);
+        }
+        const double exponent = std::log(lastSeconds / firstSeconds) / std::log(lastWork / firstWork);
+        const bool ok = exponent <= maxExponent;
+        fprintf(stderr, "%-22s exponent %.2f %s\n", family.name, exponent, ok ? "ok" : "SUPER-LINEAR");
+        failed |= !ok;
+    }
+    return failed ? 1 : 0;
+}
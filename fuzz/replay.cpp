@@ -0,0 +1,46 @@
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include <parsers.h>
+
+// Stand-in for the libFuzzer driver: feeds every file given (directories recursively) to the fuzz target once.
+// Usage: edat_fuzz_replay corpus/ crash-1234 ...
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace fs = std::filesystem;
+
+static size_t runFile(const fs::path& path)
+{
+    std::string contents;
+    if (!edat::readFile(path, contents))
+        return 0;
+    fprintf(stderr, "Running %s\n", path.string().c_str());
+    LLVMFuzzerTestOneInput((const uint8_t*)contents.data(), contents.size());
+    return 1;
+}
+
+int main(int argc, const char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s file|dir...\n", argv[0]);
+        return 1;
+    }
+    size_t count = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (fs::is_directory(argv[i]))
+        {
+            for (const fs::directory_entry& entry : fs::recursive_directory_iterator(argv[i]))
+                if (entry.is_regular_file())
+                    count += runFile(entry.path());
+        }
+        else
+            count += runFile(argv[i]);
+    }
+    fprintf(stderr, "Ran %zu inputs\n", count);
+    return 0;
+}
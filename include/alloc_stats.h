@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+
+namespace edat
+{
+
+// Allocation accounting, only available in builds configured with -DEDAT_ALLOC_STATS=ON.
+// That build replaces the global operator new/delete with counting versions; counters are per thread,
+// so measuring one call isn't disturbed by other threads. In regular builds everything here is a no-op
+// and the stats read as zero.
+struct AllocStats
+{
+    uint64_t count = 0;         // number of allocations
+    uint64_t bytes = 0;         // bytes requested by those
+    uint64_t frees = 0;
+    uint64_t peakLiveBytes = 0; // highest amount of memory held at once, above what was held at the start
+};
+
+#ifdef EDAT_ALLOC_STATS
+
+constexpr bool allocStatsEnabled = true;
+
+// Raw counters of the calling thread, maintained by the replaced operator new/delete
+struct ThreadAllocCounters
+{
+    uint64_t count;
+    uint64_t bytes;
+    uint64_t frees;
+    int64_t liveBytes; // can go negative if memory allocated on another thread is freed here
+    int64_t peakLiveBytes;
+};
+
+ThreadAllocCounters& threadAllocCounters();
+
+// Collects allocations made by the current thread while the scope is alive, scopes can be nested
+struct AllocScope
+{
+    ThreadAllocCounters start;
+    int64_t outerPeak;
+
+    AllocScope()
+    {
+        ThreadAllocCounters& counters = threadAllocCounters();
+        outerPeak = counters.peakLiveBytes;
+        counters.peakLiveBytes = counters.liveBytes;
+        start = counters;
+    }
+
+    ~AllocScope()
+    {
+        ThreadAllocCounters& counters = threadAllocCounters();
+        if (outerPeak > counters.peakLiveBytes)
+            counters.peakLiveBytes = outerPeak;
+    }
+
+    AllocStats stats() const
+    {
+        const ThreadAllocCounters& counters = threadAllocCounters();
+        AllocStats res;
+        res.count = counters.count - start.count;
+        res.bytes = counters.bytes - start.bytes;
+        res.frees = counters.frees - start.frees;
+        res.peakLiveBytes = counters.peakLiveBytes > start.liveBytes ? uint64_t(counters.peakLiveBytes - start.liveBytes) : 0;
+        return res;
+    }
+};
+
+#else
+
+constexpr bool allocStatsEnabled = false;
+
+struct AllocScope
+{
+    AllocStats stats() const { return {}; }
+};
+
+#endif
+
+// Runs `c` and returns what it allocated, e.g. to assert "no allocations per getOr" in a test:
+//   assert(!allocStatsEnabled || measureAllocations([&]() { tbl.getOr<float>("x", 0.f); }).count == 0);
+template<typename Callable>
+AllocStats measureAllocations(Callable c)
+{
+    AllocScope scope;
+    c();
+    return scope.stats();
+}
+
+}
+
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include "parsers.h"
+
+namespace edat
+{
+
+// Whatever runs the caller's coroutines, usually an event loop.
+// post() may be called from any thread, the callback has to be run on the executor's thread(s).
+struct Executor
+{
+    virtual ~Executor() {}
+    virtual void post(std::function<void()> fn) = 0;
+};
+
+// Lazily started coroutine producing a T, it starts running when awaited and resumes the awaiting
+// coroutine once done. Exceptions thrown inside are rethrown from co_await.
+template<typename T>
+struct Task
+{
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation;
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+            {
+                if (handle.promise().continuation)
+                    return handle.promise().continuation;
+                return std::noop_coroutine();
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        void return_value(T res) { value.emplace(std::move(res)); }
+        void unhandled_exception() { exception = std::current_exception(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+    Task(Task&& rhs) : handle(std::exchange(rhs.handle, nullptr)) {}
+    Task& operator=(Task&& rhs)
+    {
+        if (handle)
+            handle.destroy();
+        handle = std::exchange(rhs.handle, nullptr);
+        return *this;
+    }
+    ~Task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    bool await_ready() const { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter)
+    {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    T await_resume()
+    {
+        if (handle.promise().exception)
+            std::rethrow_exception(handle.promise().exception);
+        return std::move(*handle.promise().value);
+    }
+};
+
+// Fire-and-forget coroutine, see startTask
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// Runs a task from non-coroutine code and hands its result to `onDone`
+template<typename T, typename Callable>
+DetachedTask startTask(Task<T> task, Callable onDone)
+{
+    onDone(co_await std::move(task));
+}
+
+// co_await schedule(executor) suspends and continues as a fresh callback on the executor,
+// letting everything queued in the meantime run first
+struct ScheduleAwaiter
+{
+    Executor& executor;
+
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> handle) { executor.post([handle]() { handle.resume(); }); }
+    void await_resume() const {}
+};
+
+inline ScheduleAwaiter schedule(Executor& executor)
+{
+    return ScheduleAwaiter{executor};
+}
+
+// Reads the whole file without blocking the calling thread. With io_uring (if edat was built with it and
+// the kernel allows it) opening the file, getting its size and reading it are all queued on the ring,
+// otherwise a small pool of I/O threads does the blocking calls.
+// `done` is called on an I/O thread, with nullopt if the file couldn't be read.
+void readFileInBackground(std::filesystem::path path, std::function<void(std::optional<std::string>)> done);
+
+struct ReadFileAwaiter
+{
+    std::filesystem::path path;
+    Executor& executor;
+    std::optional<std::string> result;
+
+    bool await_ready() const { return false; }
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        readFileInBackground(path, [this, handle](std::optional<std::string> contents)
+        {
+            result = std::move(contents);
+            executor.post([handle]() { handle.resume(); });
+        });
+    }
+    std::optional<std::string> await_resume() { return std::move(result); }
+};
+
+// co_await readFileAsync(path, executor) continues on the executor once the file is read
+inline ReadFileAwaiter readFileAsync(std::filesystem::path path, Executor& executor)
+{
+    return ReadFileAwaiter{std::move(path), executor, std::nullopt};
+}
+
+// Reads and parses the file without blocking the executor: the read happens off-thread and parsing
+// gives control back to the executor after every `yieldEvery` bytes of input.
+// `psuite` has to stay alive until the task is done.
+Task<edat::Table> parseFileAsync(std::filesystem::path path, const ParserSuite& psuite, Executor& executor,
+                                 size_t yieldEvery = 256 * 1024);
+
+}
+
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+
+namespace edat
+{
+
+// Packed bools, 64 per word. Used for the bool values of a table (TypedStorage<bool>) and for `bool[]` arrays.
+// Unlike std::vector<bool> the words are accessible, the bulk queries below work on whole words
+// (std::popcount is a single instruction where the target has one, e.g. -mpopcnt or -march=native).
+// That's deliberately the whole optimization, there are no SIMD intrinsics: a word already covers 64 flags,
+// and the loops are branch-free so the compiler may vectorize them further for the target it builds for.
+// Bits past size() are always zero.
+struct BitVector
+{
+    std::vector<uint64_t> words;
+    size_t count = 0;
+
+    struct Reference
+    {
+        uint64_t* word;
+        uint64_t mask;
+
+        operator bool() const { return (*word & mask) != 0; }
+        Reference& operator=(bool value)
+        {
+            if (value)
+                *word |= mask;
+            else
+                *word &= ~mask;
+            return *this;
+        }
+        // Assigns the value, not the reference
+        Reference& operator=(const Reference& rhs) { return *this = bool(rhs); }
+    };
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    size_t capacity() const { return words.capacity() * 64; }
+
+    bool operator[](size_t idx) const { return (words[idx / 64] >> (idx % 64)) & 1; }
+    Reference operator[](size_t idx) { return {&words[idx / 64], uint64_t(1) << (idx % 64)}; }
+    Reference back() { return (*this)[count - 1]; }
+    bool back() const { return (*this)[count - 1]; }
+
+    void push_back(bool value)
+    {
+        if (count % 64 == 0)
+            words.push_back(0);
+        words.back() |= uint64_t(value) << (count % 64);
+        count++;
+    }
+
+    void pop_back()
+    {
+        count--;
+        words[count / 64] &= ~(uint64_t(1) << (count % 64));
+        if (count % 64 == 0)
+            words.pop_back();
+    }
+
+    void clear()
+    {
+        words.clear();
+        count = 0;
+    }
+
+    void reserve(size_t bits) { words.reserve((bits + 63) / 64); }
+
+    // Number of set bits
+    size_t popcount() const
+    {
+        size_t res = 0;
+        for (uint64_t word : words)
+            res += std::popcount(word);
+        return res;
+    }
+
+    bool any() const
+    {
+        uint64_t res = 0;
+        for (uint64_t word : words)
+            res |= word;
+        return res != 0;
+    }
+
+    bool all() const
+    {
+        const size_t fullWords = count / 64;
+        uint64_t res = ~uint64_t(0);
+        for (size_t i = 0; i < fullWords; ++i)
+            res &= words[i];
+        if (count % 64 != 0)
+        {
+            const uint64_t tailMask = (uint64_t(1) << (count % 64)) - 1;
+            res &= words[fullWords] | ~tailMask;
+        }
+        return res == ~uint64_t(0);
+    }
+
+    bool none() const { return !any(); }
+
+    bool operator==(const BitVector& rhs) const { return count == rhs.count && words == rhs.words; }
+};
+
+inline size_t heapBytes(const BitVector& bits)
+{
+    return bits.words.capacity() * sizeof(uint64_t);
+}
+
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+#include "edat.h"
+
+namespace edat
+{
+
+// Append-only array with stable addresses. Elements live in chunks that are never moved or freed
+// until destruction, chunk k holds (firstChunkSize << k) elements, so growing never copies anything
+// and a few dozen chunk pointers cover any realistic size. Slots are handed out with a single
+// fetch_add and chunks are allocated on first touch with a CAS, so concurrent appends don't block.
+template<typename T>
+struct ChunkedVector
+{
+    static constexpr size_t firstChunkSize = 64;
+    static constexpr size_t maxChunks = 40;
+
+    std::atomic<T*> chunks[maxChunks] = {};
+    std::atomic<size_t> count = 0;
+
+    ChunkedVector() = default;
+    ChunkedVector(const ChunkedVector&) = delete;
+    ChunkedVector& operator=(const ChunkedVector&) = delete;
+    ~ChunkedVector()
+    {
+        for (std::atomic<T*>& chunk : chunks)
+            delete[] chunk.load();
+    }
+
+    static size_t chunkIndex(size_t idx) { return std::bit_width(idx / firstChunkSize + 1) - 1; }
+    static size_t chunkStart(size_t chunk) { return firstChunkSize * ((size_t(1) << chunk) - 1); }
+
+    // Reserves a new slot and returns its index, the slot itself is default constructed
+    size_t allocate()
+    {
+        size_t idx = count.fetch_add(1);
+        (*this)[idx];
+        return idx;
+    }
+
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    T& operator[](size_t idx)
+    {
+        const size_t chunk = chunkIndex(idx);
+        T* ptr = chunks[chunk].load(std::memory_order_acquire);
+        if (!ptr)
+        {
+            T* fresh = new T[firstChunkSize << chunk];
+            if (chunks[chunk].compare_exchange_strong(ptr, fresh, std::memory_order_acq_rel))
+                ptr = fresh;
+            else
+                delete[] fresh; // someone else was faster, ptr holds theirs now
+        }
+        return ptr[idx - chunkStart(chunk)];
+    }
+
+    const T& operator[](size_t idx) const
+    {
+        return const_cast<ChunkedVector<T>&>(*this)[idx];
+    }
+};
+
+struct ConcurrentValueStorage
+{
+    size_t typeHash = 0;
+
+    virtual ~ConcurrentValueStorage() {}
+
+    virtual void copyTo(size_t idx, const std::string_view& name, Table& res) const = 0;
+    // Gives back the slot of a value that changed type, to be reused by the next value of this type
+    virtual void releaseSlot(size_t idx) = 0;
+};
+
+template<typename T>
+struct ConcurrentTypedStorage : public ConcurrentValueStorage
+{
+    ChunkedVector<T> storage;
+
+    // Released slots, only touched on type changes and when there are some (freeCount != 0)
+    std::mutex freeMutex;
+    std::vector<size_t> freeSlots;
+    std::atomic<size_t> freeCount = 0;
+
+    ConcurrentTypedStorage() { typeHash = typeid(T).hash_code(); }
+
+    void copyTo(size_t idx, const std::string_view& name, Table& res) const final
+    {
+        res.set<T>(name, T(storage[idx]));
+    }
+
+    // Callers hold the exclusive lock of the stripe of the key the slot belonged to, so nobody can be reading it
+    void releaseSlot(size_t idx) final
+    {
+        storage[idx] = T{};
+        std::lock_guard<std::mutex> lock(freeMutex);
+        freeSlots.push_back(idx);
+        freeCount.store(freeSlots.size(), std::memory_order_relaxed);
+    }
+
+    size_t acquireSlot()
+    {
+        if (freeCount.load(std::memory_order_relaxed) != 0)
+        {
+            std::lock_guard<std::mutex> lock(freeMutex);
+            if (!freeSlots.empty())
+            {
+                const size_t idx = freeSlots.back();
+                freeSlots.pop_back();
+                freeCount.store(freeSlots.size(), std::memory_order_relaxed);
+                return idx;
+            }
+        }
+        return storage.allocate();
+    }
+};
+
+// Table variant for several threads adding and reading keys at the same time.
+// The name index is split into stripes with a reader-writer lock each, so writers only contend
+// when their keys hash to the same stripe and readers only ever take shared locks. Values and
+// records are kept in ChunkedVectors, so nothing is ever moved once added and references obtained
+// through get() stay valid for the lifetime of the table.
+// Overwriting a value takes the stripe's exclusive lock, so readers never see a half-written value.
+// When a key changes type its old slot is released to the old type's storage and reused by the next
+// value of that type, so keys flipping between types don't grow the storages without bound.
+struct ConcurrentTable
+{
+    static constexpr size_t stripeCount = 64;
+    static constexpr size_t maxTypes = 64;
+
+    struct Record
+    {
+        std::string name;
+        size_t storageId = size_t(-1);
+        size_t idx = size_t(-1);
+        std::atomic<bool> ready = false; // set once the record is filled, getAll skips slots still being written
+    };
+
+    struct alignas(64) Stripe
+    {
+        mutable std::shared_mutex mutex;
+        StringMap<size_t> nameMap; // name to index in records
+    };
+
+    Stripe stripes[stripeCount];
+    ChunkedVector<Record> records;
+
+    std::mutex typesMutex; // only taken to register a type that wasn't seen before
+    std::atomic<ConcurrentValueStorage*> storages[maxTypes] = {};
+    std::atomic<size_t> storageCount = 0;
+
+    ConcurrentTable() = default;
+    ConcurrentTable(const ConcurrentTable&) = delete;
+    ConcurrentTable& operator=(const ConcurrentTable&) = delete;
+    ~ConcurrentTable()
+    {
+        for (std::atomic<ConcurrentValueStorage*>& storage : storages)
+            delete storage.load();
+    }
+
+    Stripe& stripeFor(const std::string_view& name) const
+    {
+        const size_t hash = StringHash{}(name);
+        // Mix in the high bits, the low ones also pick the bucket inside the stripe's map
+        return const_cast<Stripe&>(stripes[(hash ^ (hash >> 29)) % stripeCount]);
+    }
+
+    template<typename T>
+    size_t getOrCreateStorageForType()
+    {
+        const size_t typeHash = typeid(T).hash_code();
+        // Fast path, types are only ever appended so scanning without the lock is fine
+        size_t count = storageCount.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i)
+            if (storages[i].load(std::memory_order_acquire)->typeHash == typeHash)
+                return i;
+
+        std::lock_guard<std::mutex> lock(typesMutex);
+        count = storageCount.load();
+        for (size_t i = 0; i < count; ++i)
+            if (storages[i].load()->typeHash == typeHash)
+                return i;
+        if (count == maxTypes)
+        {
+            printf("Error: ConcurrentTable supports at most %zu value types\n", maxTypes);
+            return size_t(-1);
+        }
+        storages[count].store(new ConcurrentTypedStorage<T>(), std::memory_order_release);
+        storageCount.store(count + 1, std::memory_order_release);
+        return count;
+    }
+
+    template<typename T>
+    ConcurrentTypedStorage<T>* getTypedStorage(size_t storageId) const
+    {
+        if (storageId >= maxTypes)
+            return nullptr;
+        ConcurrentValueStorage* storage = storages[storageId].load(std::memory_order_acquire);
+        if (!storage || storage->typeHash != typeid(T).hash_code())
+            return nullptr;
+        return (ConcurrentTypedStorage<T>*)storage;
+    }
+
+    template<typename T>
+    T getOr(const std::string_view& name, T def) const
+    {
+        const Stripe& stripe = stripeFor(name);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        auto itf = stripe.nameMap.find(name);
+        if (itf == stripe.nameMap.end())
+            return def;
+        const Record& rec = records[itf->second];
+        if (ConcurrentTypedStorage<T>* tstorage = getTypedStorage<T>(rec.storageId))
+            return tstorage->storage[rec.idx];
+        return def;
+    }
+
+    // The callable runs under the stripe's shared lock, keep it short
+    template<typename T, typename Callable>
+    void get(const std::string_view& name, Callable c) const
+    {
+        const Stripe& stripe = stripeFor(name);
+        std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+        auto itf = stripe.nameMap.find(name);
+        if (itf == stripe.nameMap.end())
+            return;
+        const Record& rec = records[itf->second];
+        if (ConcurrentTypedStorage<T>* tstorage = getTypedStorage<T>(rec.storageId))
+            c(std::as_const(tstorage->storage[rec.idx]));
+    }
+
+    template<typename T>
+    void set(const std::string_view& name, T&& value)
+    {
+        using Value = std::decay_t<T>;
+        const size_t storageId = getOrCreateStorageForType<Value>();
+        ConcurrentTypedStorage<Value>* tstorage = getTypedStorage<Value>(storageId);
+        if (!tstorage)
+            return;
+
+        Stripe& stripe = stripeFor(name);
+        std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+        auto itf = stripe.nameMap.find(name);
+        if (itf != stripe.nameMap.end())
+        {
+            Record& rec = records[itf->second];
+            if (rec.storageId == storageId)
+            {
+                tstorage->storage[rec.idx] = std::forward<T>(value);
+                return;
+            }
+            // Type changed, the old slot goes back to its storage (chunks are append-only, slots are reused)
+            const size_t newIdx = tstorage->acquireSlot();
+            tstorage->storage[newIdx] = std::forward<T>(value);
+            storages[rec.storageId].load(std::memory_order_acquire)->releaseSlot(rec.idx);
+            rec.idx = newIdx;
+            rec.storageId = storageId;
+            return;
+        }
+
+        const size_t idx = tstorage->acquireSlot();
+        tstorage->storage[idx] = std::forward<T>(value);
+
+        const size_t recordIdx = records.allocate();
+        Record& rec = records[recordIdx];
+        rec.name = name;
+        rec.storageId = storageId;
+        rec.idx = idx;
+        rec.ready.store(true, std::memory_order_release);
+        stripe.nameMap.emplace(std::string(name), recordIdx);
+    }
+
+    // Visits entries of type T in insertion order. Entries added concurrently may or may not be visited.
+    template<typename T, typename Callable>
+    void getAll(Callable c) const
+    {
+        const size_t count = records.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Record& rec = records[i];
+            if (!rec.ready.load(std::memory_order_acquire))
+                continue;
+            const Stripe& stripe = stripeFor(rec.name);
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            if (ConcurrentTypedStorage<T>* tstorage = getTypedStorage<T>(rec.storageId))
+                c(rec.name, std::as_const(tstorage->storage[rec.idx]));
+        }
+    }
+
+    // Number of keys, including the ones which are still being added
+    size_t size() const { return records.size(); }
+
+    // Copies everything into a regular Table, in insertion order.
+    // Meant for the point where ingestion is done and reads should be lock-free (see Snapshot).
+    Table toTable() const
+    {
+        Table res;
+        const size_t count = records.size();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Record& rec = records[i];
+            if (!rec.ready.load(std::memory_order_acquire))
+                continue;
+            const Stripe& stripe = stripeFor(rec.name);
+            std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+            storages[rec.storageId].load(std::memory_order_acquire)->copyTo(rec.idx, rec.name, res);
+        }
+        return res;
+    }
+};
+
+}
+
@@ -2,51 +2,242 @@
 
 // TODO: replace with better containers eventually?
 #include <vector>
+#include <span>
 #include <string_view>
 #include <string>
 #include <unordered_map>
 #include <typeinfo>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <utility>
+
+#include "bit_vector.h"
 
 namespace edat
 {
 
+struct Table;
+struct MemoryUsage;
+struct ShapeRegistry;
+template<typename T>
+struct Handle;
+
+// Lets unordered_maps keyed by std::string be searched with a string_view without building a temporary std::string
+struct StringHash
+{
+    using is_transparent = void;
+
+    size_t operator()(const std::string_view& str) const { return std::hash<std::string_view>{}(str); }
+};
+
+template<typename T>
+using StringMap = std::unordered_map<std::string, T, StringHash, std::equal_to<>>;
+
+// Lookup hits per key, collected by Table::enableProfiling and used by Table::optimizeLayout.
+// Keys of nested tables are dotted paths ("parent.child.key"), see saveProfile/loadProfile to keep it around.
+struct AccessProfile
+{
+    StringMap<uint64_t> hits;
+};
+
 struct ValueStorage
 {
     virtual ~ValueStorage() {}
 
     virtual ValueStorage* clone() const = 0;
+    // Empty storage of the same type
+    virtual ValueStorage* createEmpty() const = 0;
+    virtual const std::type_info& type() const = 0;
+    // Moves the last value into `idx` and shrinks by one
+    virtual void swapRemove(size_t idx) = 0;
+    // Copies a single value into another table under `name`
+    virtual void copyValueTo(size_t idx, const std::string_view& name, Table& dst) const = 0;
+    // Appends a single value of `src` (a storage of the same type), copied or moved out
+    virtual void pushCopy(const ValueStorage& src, size_t idx) = 0;
+    virtual void pushMoved(ValueStorage& src, size_t idx) = 0;
+    // Rearranges values so that the new i-th value is the old order[i]-th
+    virtual void reorder(const std::vector<size_t>& order) = 0;
+    // Drops all values, keeping the capacity
+    virtual void clear() = 0;
+    // Bytes of memory owned by the storage, including what the values themselves allocate
+    virtual size_t memoryUsage() const = 0;
+};
+
+// What the values of a type are kept in, bools are packed into bits
+template<typename T>
+struct ValueContainer
+{
+    using type = std::vector<T>;
+};
+
+template<>
+struct ValueContainer<bool>
+{
+    using type = BitVector;
 };
 
 // Do we need classes here? Storing ptr to underlying container might be enough?
 template<typename T>
 struct TypedStorage : public ValueStorage
 {
-    std::vector<T> storage;
+    typename ValueContainer<T>::type storage;
 
     virtual ~TypedStorage() {} // just do the automatic stuff
     ValueStorage* clone() const final;
+    ValueStorage* createEmpty() const final { return new TypedStorage<T>(); }
+    const std::type_info& type() const final { return typeid(T); }
+    void swapRemove(size_t idx) final
+    {
+        if (idx + 1 < storage.size())
+            storage[idx] = std::move(storage.back());
+        storage.pop_back();
+    }
+    void copyValueTo(size_t idx, const std::string_view& name, Table& dst) const final;
+    void pushCopy(const ValueStorage& src, size_t idx) final;
+    void pushMoved(ValueStorage& src, size_t idx) final { storage.push_back(std::move(((TypedStorage<T>&)src).storage[idx])); }
+    size_t memoryUsage() const final;
+    void reorder(const std::vector<size_t>& order) final
+    {
+        typename ValueContainer<T>::type newStorage;
+        newStorage.reserve(storage.size());
+        for (size_t idx : order)
+            newStorage.push_back(std::move(storage[idx]));
+        storage = std::move(newStorage);
+    }
+    void clear() final { storage.clear(); }
 };
 
-struct Table
+// Contiguous values of one type together with the names they belong to, see Table::view
+template<typename T>
+struct TypedView
+{
+    std::span<const T> values;
+    std::span<const size_t> nameIds; // parallel to values
+    const std::vector<std::string>* names = nullptr;
+
+    size_t size() const { return values.size(); }
+    const std::string& name(size_t i) const { return (*names)[nameIds[i]]; }
+};
+
+// Bools are bits, they can't be a span. The BitVector has the bulk queries (popcount, any, all) instead
+template<>
+struct TypedView<bool>
+{
+    const BitVector* values = nullptr;
+    std::span<const size_t> nameIds; // parallel to values
+    const std::vector<std::string>* names = nullptr;
+
+    size_t size() const { return values ? values->size() : 0; }
+    const std::string& name(size_t i) const { return (*names)[nameIds[i]]; }
+};
+
+// Everything about a table except its values: the keys, where each value lives and which types are stored.
+// Tables with the same layout (like sibling subtables with the same keys) share one shape, see ShapeRegistry,
+// so each of them only pays for its values. A shared shape is never changed, a table copies it first.
+struct Shape
 {
-    struct TableRecord
+    struct Record
     {
         size_t nameId = size_t(-1);
         size_t storageId = size_t(-1);
         size_t idx = size_t(-1);
+
+        bool operator==(const Record& rhs) const = default;
     };
 
     // TODO: think about how to remove duplicate names here as we have the same name in `names` and `nameMap` (for quick lookup)
+    // `names` and `records` are parallel, so a nameId is also the index of its record
     std::vector<std::string> names;
-    std::vector<TableRecord> records;
-    std::unordered_map<std::string, size_t> nameMap;
+    std::vector<Record> records;
+    StringMap<size_t> nameMap;
+
+    std::unordered_map<size_t, size_t> typeHashMap; // maps type hash_code to index in Table::storages
+    // Owner of every value per storage, parallel to the typed storage (index into names)
+    std::vector<std::vector<size_t>> nameIds;
+
+    // nameMap follows from names and records
+    bool operator==(const Shape& rhs) const
+    {
+        return names == rhs.names && records == rhs.records && typeHashMap == rhs.typeHashMap && nameIds == rhs.nameIds;
+    }
+
+    size_t hash() const
+    {
+        size_t res = nameIds.size();
+        auto combine = [&res](size_t h) { res ^= h + 0x9e3779b97f4a7c15ull + (res << 6) + (res >> 2); };
+        for (const std::string& name : names)
+            combine(std::hash<std::string>{}(name));
+        for (const Record& rec : records)
+        {
+            combine(rec.storageId);
+            combine(rec.idx);
+        }
+        return res;
+    }
+
+    // Bytes of memory owned by the shape, see Table::memoryUsage
+    size_t namesMemoryBytes() const;
+    size_t recordsMemoryBytes() const;
+    size_t nameMapMemoryBytes() const;
+    size_t typeHashMapMemoryBytes() const;
+    size_t memoryBytes() const;
+};
+
+// What a table starts with, shared by all empty tables
+inline const std::shared_ptr<Shape>& emptyShape()
+{
+    static const std::shared_ptr<Shape> shape = std::make_shared<Shape>();
+    return shape;
+}
 
-    std::unordered_map<size_t, size_t> typeHashMap; // maps type hash_code to index in storages
+struct Table
+{
+    using TableRecord = Shape::Record;
+
+    std::shared_ptr<Shape> shape = emptyShape();
+    // Parallel to shape->nameIds
     std::vector<ValueStorage*> storages;
 
+    // Bumped by every change that can move values around (new keys, type changes, erase, compaction, layout changes),
+    // lets Handle know when its cached pointer has to be resolved again
+    uint64_t version = 0;
+
+    // Lookup hits per record while profiling is on (parallel to records), see enableProfiling
+    std::unique_ptr<std::vector<uint64_t>> accessCounts;
+
+    // Names and map nodes left over by clear(), new keys reuse them instead of allocating
+    std::vector<std::string> spareNames;
+    std::vector<StringMap<size_t>::node_type> spareNodes;
+
     Table() = default;
-    Table(Table&& rhs) = default;
-    Table& operator=(Table&& rhs) = default;
+    // The moved from table is left empty, not without a shape
+    Table(Table&& rhs)
+        : shape(std::exchange(rhs.shape, emptyShape())), storages(std::move(rhs.storages)), version(rhs.version),
+          accessCounts(std::move(rhs.accessCounts)), spareNames(std::move(rhs.spareNames)), spareNodes(std::move(rhs.spareNodes))
+    {
+        rhs.storages.clear();
+        // Handles to the moved from table must not keep pointing at values that are ours now
+        rhs.version++;
+    }
+    Table& operator=(Table&& rhs)
+    {
+        if (this == &rhs)
+            return *this;
+        for (ValueStorage* storage : storages)
+            delete storage;
+        shape = std::exchange(rhs.shape, emptyShape());
+        storages = std::move(rhs.storages);
+        rhs.storages.clear();
+        accessCounts = std::move(rhs.accessCounts);
+        spareNames = std::move(rhs.spareNames);
+        spareNodes = std::move(rhs.spareNodes);
+        // Contents are replaced, handles to this table have to notice even if the versions happen to match
+        version = std::max(version, rhs.version) + 1;
+        rhs.version++;
+        return *this;
+    }
     // Clean all the storages!
     ~Table()
     {
@@ -54,14 +245,36 @@ struct Table
             delete storage;
     }
 
+    // True if no other table uses the shape anymore, so it can be changed in place.
+    // use_count() is a relaxed load: a table on another thread may have just released its reference after
+    // reading the shape, the fence orders those reads before our writes (pairs with the release in the
+    // shared_ptr decrement).
+    bool ownsShape() const
+    {
+        if (shape.use_count() > 1)
+            return false;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return true;
+    }
+
+    // The shape for changing it, copied first if other tables use it too
+    Shape& mutableShape()
+    {
+        if (!ownsShape())
+            shape = std::make_shared<Shape>(*shape);
+        return *shape;
+    }
+
     // TODO: think about it, maybe standalone inline functions will work best here?
     // Syntax sugar is good, but keeping everything tidy and clean might be better?
     TableRecord findIndex(const std::string_view& name) const
     {
-        auto itf = nameMap.find(std::string(name));
-        if (itf == nameMap.end())
+        auto itf = shape->nameMap.find(name);
+        if (itf == shape->nameMap.end())
             return {size_t(-1), size_t(-1)};
-        return records[itf->second];
+        if (accessCounts) [[unlikely]]
+            std::atomic_ref<uint64_t>((*accessCounts)[itf->second]).fetch_add(1, std::memory_order_relaxed);
+        return shape->records[itf->second];
     }
 
     template<typename T>
@@ -80,22 +293,23 @@ struct Table
     size_t getOrCreateStorageForType()
     {
         const size_t typeHash = typeid(T).hash_code();
-        auto itf = typeHashMap.find(typeHash);
-        if (itf == typeHashMap.end())
-        {
-            // We don't have that type registered yet, register
-            typeHashMap.emplace(typeHash, storages.size());
-            storages.emplace_back(new TypedStorage<T>());
-        }
-        return typeHashMap[typeHash];
+        auto itf = shape->typeHashMap.find(typeHash);
+        if (itf != shape->typeHashMap.end())
+            return itf->second;
+        // We don't have that type registered yet, register
+        Shape& s = mutableShape();
+        s.typeHashMap.emplace(typeHash, storages.size());
+        s.nameIds.emplace_back();
+        storages.emplace_back(new TypedStorage<T>());
+        return storages.size() - 1;
     }
 
     template<typename T>
     size_t getStorageByType() const
     {
         const size_t typeHash = typeid(T).hash_code();
-        auto itf = typeHashMap.find(typeHash);
-        if (itf == typeHashMap.end())
+        auto itf = shape->typeHashMap.find(typeHash);
+        if (itf == shape->typeHashMap.end())
             return size_t(-1);
         // We can safely access it here now
         return itf->second;
@@ -121,42 +335,260 @@ struct Table
     template<typename T>
     void set(const std::string_view& name, T&& value)
     {
-        const TableRecord rec = findIndex(name);
-        if (rec.storageId < storages.size()) // we have this value already, just need to set it
+        auto itf = shape->nameMap.find(name);
+        if (itf != shape->nameMap.end()) // we have this value already, just need to set it
         {
-            getTypedStorage<T>(rec.storageId)->storage[rec.idx] = std::move(value);
+            const size_t recordIdx = itf->second;
+            const size_t storageId = getOrCreateStorageForType<T>();
+            const TableRecord& rec = shape->records[recordIdx];
+            if (rec.storageId == storageId)
+            {
+                getTypedStorage<T>(rec.storageId)->storage[rec.idx] = std::move(value);
+                return;
+            }
+            // Type has changed, move the value over to the new type's storage
+            removeValue(rec.storageId, rec.idx);
+            Shape& s = mutableShape();
+            TypedStorage<T>* tstorage = getTypedStorage<T>(storageId);
+            s.records[recordIdx].storageId = storageId;
+            s.records[recordIdx].idx = tstorage->storage.size();
+            tstorage->storage.push_back(std::move(value));
+            s.nameIds[storageId].push_back(recordIdx);
             return;
         }
 
         // Otherwise - create the value
+        version++;
         const size_t storageId = getOrCreateStorageForType<T>();
+        Shape& s = mutableShape();
         TypedStorage<T>* tstorage = getTypedStorage<T>(storageId);
         const size_t idx = tstorage->storage.size();
 
         // Push the value itself
+        size_t nameId = s.names.size();
         tstorage->storage.push_back(std::move(value));
+        s.nameIds[storageId].push_back(nameId);
 
         // Update the nameMap with newly pushed value
-        size_t nameId = names.size();
-        names.emplace_back(name);
-        size_t recordIdx = records.size();
-        records.emplace_back(TableRecord{nameId, storageId, idx});
-        nameMap.emplace(std::string(name), recordIdx);
+        if (spareNames.empty())
+            s.names.emplace_back(name);
+        else
+        {
+            s.names.push_back(std::move(spareNames.back()));
+            spareNames.pop_back();
+            s.names.back().assign(name);
+        }
+        size_t recordIdx = s.records.size();
+        s.records.emplace_back(TableRecord{nameId, storageId, idx});
+        if (spareNodes.empty())
+            s.nameMap.emplace(std::string(name), recordIdx);
+        else
+        {
+            StringMap<size_t>::node_type node = std::move(spareNodes.back());
+            spareNodes.pop_back();
+            node.key().assign(name);
+            node.mapped() = recordIdx;
+            s.nameMap.insert(std::move(node));
+        }
+        if (accessCounts)
+            accessCounts->push_back(0);
+    }
+
+    // Removes a value from its storage, keeping the storage dense
+    void removeValue(size_t storageId, size_t idx)
+    {
+        version++;
+        Shape& s = mutableShape();
+        storages[storageId]->swapRemove(idx);
+        std::vector<size_t>& nameIds = s.nameIds[storageId];
+        if (idx + 1 < nameIds.size())
+        {
+            nameIds[idx] = nameIds.back();
+            s.records[nameIds[idx]].idx = idx;
+        }
+        nameIds.pop_back();
+    }
+
+    // Removes the key, returns false if there was no such key.
+    // The record and name stay behind as a tombstone until compact()
+    bool erase(const std::string_view& name)
+    {
+        auto itf = shape->nameMap.find(name);
+        if (itf == shape->nameMap.end())
+            return false;
+        const size_t recordIdx = itf->second;
+        removeValue(shape->records[recordIdx].storageId, shape->records[recordIdx].idx);
+        Shape& s = mutableShape();
+        s.records[recordIdx].storageId = size_t(-1);
+        s.records[recordIdx].idx = size_t(-1);
+        s.nameMap.erase(s.nameMap.find(name));
+        return true;
     }
 
+    // Removes all the keys but keeps every bit of memory: containers keep their capacity, registered types
+    // keep their storages, and names and map nodes are kept aside for the next keys.
+    // Filling a cleared table with a similar set of keys again doesn't allocate (values themselves aside).
+    void clear()
+    {
+        version++;
+        if (!ownsShape())
+        {
+            // Not ours to clear, start over with a shape that only keeps the registered types
+            std::shared_ptr<Shape> fresh = std::make_shared<Shape>();
+            fresh->typeHashMap = shape->typeHashMap;
+            fresh->nameIds.resize(storages.size());
+            shape = std::move(fresh);
+        }
+        else
+        {
+            for (std::string& name : shape->names)
+                spareNames.push_back(std::move(name));
+            shape->names.clear();
+            shape->records.clear();
+            while (!shape->nameMap.empty())
+                spareNodes.push_back(shape->nameMap.extract(shape->nameMap.begin()));
+            for (std::vector<size_t>& nameIds : shape->nameIds)
+                nameIds.clear();
+        }
+        for (ValueStorage* storage : storages)
+            storage->clear();
+        if (accessCounts)
+            accessCounts->clear();
+    }
+
+    // Makes room for `count` keys in total
+    void reserve(size_t count)
+    {
+        Shape& s = mutableShape();
+        s.names.reserve(count);
+        s.records.reserve(count);
+        s.nameMap.reserve(count);
+    }
+
+    // Drops the tombstones left by erase, renumbering names and records
+    void compact()
+    {
+        const std::vector<TableRecord>& records = shape->records;
+        if (std::all_of(records.begin(), records.end(), [&](const TableRecord& rec) { return rec.storageId < storages.size(); }))
+            return;
+        version++;
+        Shape& s = mutableShape();
+        std::vector<size_t> newNameIds(s.records.size(), size_t(-1));
+        size_t count = 0;
+        for (size_t i = 0; i < s.records.size(); ++i)
+        {
+            if (s.records[i].storageId >= storages.size())
+                continue;
+            newNameIds[i] = count;
+            if (count != i)
+            {
+                s.names[count] = std::move(s.names[i]);
+                s.records[count] = s.records[i];
+                if (accessCounts)
+                    (*accessCounts)[count] = (*accessCounts)[i];
+            }
+            s.records[count].nameId = count;
+            count++;
+        }
+        s.names.resize(count);
+        s.records.resize(count);
+        if (accessCounts)
+            accessCounts->resize(count);
+        for (auto& [name, recordIdx] : s.nameMap)
+            recordIdx = newNameIds[recordIdx];
+        for (std::vector<size_t>& nameIds : s.nameIds)
+            for (size_t& nameId : nameIds)
+                nameId = newNameIds[nameId];
+    }
+
+    // Makes this table and its nested tables use the shapes registered in `registry` when they have the same layout,
+    // registering the new ones
+    void shareShapes(ShapeRegistry& registry);
+
+    // Accessor that caches where the value lives, see Handle
+    template<typename T>
+    Handle<T> handle(const std::string_view& name) const;
+
+    // All values of type T as one contiguous span, for bulk processing (see reduce.h).
+    // Values are in insertion order unless some were erased or changed type (those swap the last value in),
+    // or the layout was optimized. Bools come as their BitVector, e.g. view<bool>().values->popcount() flags are set.
+    template<typename T>
+    TypedView<T> view() const
+    {
+        TypedView<T> res;
+        res.names = &shape->names;
+        const size_t storageId = getStorageByType<T>();
+        if (storageId == size_t(-1))
+            return res;
+        const TypedStorage<T>* tstorage = getTypedStorage<T>(storageId);
+        if constexpr (std::is_same_v<T, bool>)
+            res.values = &tstorage->storage;
+        else
+            res.values = tstorage->storage;
+        res.nameIds = shape->nameIds[storageId];
+        return res;
+    }
+
+    // Starts counting lookup hits of every key (of nested tables too), which costs an atomic increment per lookup.
+    // Lookups from several threads are fine, like without profiling.
+    void enableProfiling();
+    void disableProfiling();
+    // Hits so far, added to `profile` under `prefix` + name
+    void collectProfile(AccessProfile& profile, const std::string& prefix = {}) const;
+    // Reorders keys by their hits in `profile` (under `prefix`), hottest first, nested tables included.
+    // Hot records and values end up next to each other in memory, and hot keys come first in their hash buckets.
+    // Drops tombstones like compact(), handles are resolved again afterwards.
+    // Tables get their own copy of a shared shape, shareShapes() can share them again.
+    void optimizeLayout(const AccessProfile& profile, const std::string& prefix = {});
+
+    // Approximate bytes of memory owned by the table (containers, names and values, nested tables included).
+    // Allocator overhead isn't accounted for.
+    size_t memoryBytes() const;
+    // Same broken down by structure, per value type and per nested table
+    MemoryUsage memoryUsage() const;
+
+    // Shape parts are divided between the tables sharing the shape
+    size_t shapeShares() const { return (size_t)shape.use_count(); }
+    size_t namesMemoryBytes() const;
+    size_t recordsMemoryBytes() const;
+    size_t nameMapMemoryBytes() const;
+    size_t typeHashMapMemoryBytes() const;
+
     template<typename T, typename Callable>
     void getAll(Callable c) const
     {
         const size_t typeHash = typeid(T).hash_code();
-        auto itf = typeHashMap.find(typeHash);
-        if (itf == typeHashMap.end())
+        auto itf = shape->typeHashMap.find(typeHash);
+        if (itf == shape->typeHashMap.end())
             return;
 
         const size_t storageId = itf->second;
         const TypedStorage<T>* tstorage = getTypedStorage<T>(storageId);
-        for (const TableRecord& record : records)
+        for (const TableRecord& record : shape->records)
             if (record.storageId == storageId)
-                c(names[record.nameId], tstorage->storage[record.idx]);
+                c(shape->names[record.nameId], tstorage->storage[record.idx]);
+    }
+};
+
+// Shapes by content, so that tables with the same layout can share one (see Table::shareShapes).
+// Parsing shares the shapes of a whole document this way, the registry only has to live as long as that.
+struct ShapeRegistry
+{
+    std::unordered_map<size_t, std::vector<std::shared_ptr<Shape>>> shapes; // by Shape::hash
+
+    // Makes `tbl` use the registered shape equal to its own, or registers its shape if there's none
+    void intern(Table& tbl)
+    {
+        std::vector<std::shared_ptr<Shape>>& candidates = shapes[tbl.shape->hash()];
+        for (const std::shared_ptr<Shape>& shape : candidates)
+        {
+            if (shape == tbl.shape || *shape == *tbl.shape)
+            {
+                tbl.shape = shape;
+                return;
+            }
+        }
+        candidates.push_back(tbl.shape);
     }
 };
 
@@ -164,23 +596,67 @@ inline edat::Table cloneTable(const edat::Table& tbl)
 {
     edat::Table res;
 
-    res.names = tbl.names;
-    res.records = tbl.records;
-    res.nameMap = tbl.nameMap;
-    res.typeHashMap = tbl.typeHashMap;
-
+    // Same layout, the shape is copied only once either of them changes it
+    res.shape = tbl.shape;
     for (const ValueStorage* s : tbl.storages)
         res.storages.push_back(s->clone());
 
     return res;
 }
 
+// Lightweight accessor to a single value. The resolved pointer is cached together with the table's version,
+// so as long as the table isn't structurally changed get() is a single integer compare and a load.
+// Values overwritten through set() are seen right away, they don't move.
+// The handle references the table itself, so it must not outlive it. After the table is moved from the
+// handle finds nothing, it doesn't follow the values (nested tables move when their parent gets new table entries).
+template<typename T>
+struct Handle
+{
+    static_assert(!std::is_same_v<T, bool>, "bool values are packed bits without an address, read them with Table::getOr");
+
+    const Table* table = nullptr;
+    std::string name;
+    mutable uint64_t version = 0;
+    mutable const T* value = nullptr;
+
+    Handle() = default;
+    Handle(const Table& tbl, const std::string_view& name) : table(&tbl), name(name) { resolve(); }
+
+    // nullptr if the table has no such key of type T
+    const T* get() const
+    {
+        if (table->version != version)
+            resolve();
+        return value;
+    }
+
+    T getOr(T def) const
+    {
+        const T* res = get();
+        return res ? *res : def;
+    }
+
+    void resolve() const
+    {
+        version = table->version;
+        value = nullptr;
+        const Table::TableRecord rec = table->findIndex(name);
+        if (rec.storageId < table->storages.size() && rec.storageId == table->getStorageByType<T>())
+            value = &table->getTypedStorage<T>(rec.storageId)->storage[rec.idx];
+    }
+};
+
+template<typename T>
+inline Handle<T> Table::handle(const std::string_view& name) const
+{
+    return Handle<T>(*this, name);
+}
+
 template<typename T>
 inline ValueStorage* TypedStorage<T>::clone() const
 {
     TypedStorage<T>* res = new TypedStorage<T>();
-    for (const T& v : storage)
-        res->storage.push_back(v);
+    res->storage = storage;
     return res;
 }
 
@@ -193,5 +669,321 @@ inline ValueStorage* TypedStorage<Table>::clone() const
     return res;
 }
 
+template<typename T>
+inline void TypedStorage<T>::pushCopy(const ValueStorage& src, size_t idx)
+{
+    storage.push_back(((const TypedStorage<T>&)src).storage[idx]);
+}
+
+template<>
+inline void TypedStorage<Table>::pushCopy(const ValueStorage& src, size_t idx)
+{
+    storage.push_back(cloneTable(((const TypedStorage<Table>&)src).storage[idx]));
+}
+
+// Heap memory owned by a single value, on top of its sizeof
+template<typename T>
+inline size_t heapBytes(const T&)
+{
+    return 0;
+}
+
+inline size_t heapBytes(const std::string& str)
+{
+    // Short strings live inside the object itself
+    const char* data = str.data();
+    const char* self = (const char*)&str;
+    if (data >= self && data < self + sizeof(str))
+        return 0;
+    return str.capacity() + 1;
+}
+
+inline size_t heapBytes(const Table& tbl)
+{
+    return tbl.memoryBytes();
+}
+
+template<typename T>
+inline size_t heapBytes(const std::vector<T>& vec)
+{
+    size_t res = vec.capacity() * sizeof(T);
+    for (const T& v : vec)
+        res += heapBytes(v);
+    return res;
+}
+
+template<typename T>
+inline size_t TypedStorage<T>::memoryUsage() const
+{
+    return sizeof(*this) + heapBytes(storage);
+}
+
+inline void Table::enableProfiling()
+{
+    if (!accessCounts)
+        accessCounts = std::make_unique<std::vector<uint64_t>>(shape->records.size(), 0);
+    const size_t storageId = getStorageByType<Table>();
+    if (storageId != size_t(-1))
+        for (Table& sub : getTypedStorage<Table>(storageId)->storage)
+            sub.enableProfiling();
+}
+
+inline void Table::shareShapes(ShapeRegistry& registry)
+{
+    registry.intern(*this);
+    const size_t storageId = getStorageByType<Table>();
+    if (storageId != size_t(-1))
+        for (Table& sub : getTypedStorage<Table>(storageId)->storage)
+            sub.shareShapes(registry);
+}
+
+inline void Table::disableProfiling()
+{
+    accessCounts.reset();
+    const size_t storageId = getStorageByType<Table>();
+    if (storageId != size_t(-1))
+        for (Table& sub : getTypedStorage<Table>(storageId)->storage)
+            sub.disableProfiling();
+}
+
+inline void Table::collectProfile(AccessProfile& profile, const std::string& prefix) const
+{
+    if (accessCounts)
+        for (const auto& [name, recordIdx] : shape->nameMap)
+            if (uint64_t hits = (*accessCounts)[recordIdx])
+                profile.hits[prefix + name] += hits;
+    const size_t storageId = getStorageByType<Table>();
+    if (storageId == size_t(-1))
+        return;
+    const TypedStorage<Table>* tstorage = getTypedStorage<Table>(storageId);
+    for (size_t i = 0; i < tstorage->storage.size(); ++i)
+        tstorage->storage[i].collectProfile(profile, prefix + shape->names[shape->nameIds[storageId][i]] + ".");
+}
+
+inline void Table::optimizeLayout(const AccessProfile& profile, const std::string& prefix)
+{
+    compact();
+    Shape& s = mutableShape();
+    std::vector<uint64_t> hits(s.records.size(), 0);
+    std::string path = prefix;
+    for (size_t i = 0; i < s.names.size(); ++i)
+    {
+        path.resize(prefix.size());
+        path += s.names[i];
+        auto itf = profile.hits.find(path);
+        if (itf != profile.hits.end())
+            hits[i] = itf->second;
+    }
+
+    // Hottest first, the rest keeps its order
+    std::vector<size_t> order(s.records.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return hits[a] > hits[b]; });
+
+    version++;
+    std::vector<size_t> newNameIds(order.size());
+    std::vector<std::string> newNames(order.size());
+    std::vector<TableRecord> newRecords(order.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        newNameIds[order[i]] = i;
+        newNames[i] = std::move(s.names[order[i]]);
+        newRecords[i] = s.records[order[i]];
+        newRecords[i].nameId = i;
+    }
+    if (accessCounts)
+    {
+        std::vector<uint64_t> newCounts(order.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            newCounts[i] = (*accessCounts)[order[i]];
+        *accessCounts = std::move(newCounts);
+    }
+    s.names = std::move(newNames);
+    s.records = std::move(newRecords);
+
+    // Values follow the same order within every storage
+    std::vector<std::vector<size_t>> storageOrders(storages.size());
+    for (TableRecord& rec : s.records)
+    {
+        std::vector<size_t>& storageOrder = storageOrders[rec.storageId];
+        storageOrder.push_back(rec.idx);
+        rec.idx = storageOrder.size() - 1;
+    }
+    for (size_t storageId = 0; storageId < storages.size(); ++storageId)
+    {
+        storages[storageId]->reorder(storageOrders[storageId]);
+        std::vector<size_t>& nameIds = s.nameIds[storageId];
+        std::vector<size_t> newIds;
+        newIds.reserve(nameIds.size());
+        for (size_t idx : storageOrders[storageId])
+            newIds.push_back(newNameIds[nameIds[idx]]);
+        nameIds = std::move(newIds);
+    }
+
+    // Buckets are chained and a new node goes to the front of its bucket (libstdc++, libc++),
+    // so inserting coldest first leaves the hottest key first in every bucket
+    s.nameMap.clear();
+    s.nameMap.reserve(s.names.size());
+    for (size_t i = s.names.size(); i-- > 0;)
+        s.nameMap.emplace(s.names[i], i);
+
+    const size_t tableStorageId = getStorageByType<Table>();
+    if (tableStorageId == size_t(-1))
+        return;
+    TypedStorage<Table>* tstorage = getTypedStorage<Table>(tableStorageId);
+    for (size_t i = 0; i < tstorage->storage.size(); ++i)
+        tstorage->storage[i].optimizeLayout(profile, prefix + s.names[s.nameIds[tableStorageId][i]] + ".");
+}
+
+inline size_t Shape::namesMemoryBytes() const
+{
+    return heapBytes(names);
+}
+
+// Records and the owner of every value
+inline size_t Shape::recordsMemoryBytes() const
+{
+    return records.capacity() * sizeof(Record) + heapBytes(nameIds);
+}
+
+// Node based maps: a node per element (value, next pointer and the cached hash) plus the bucket array
+inline size_t Shape::nameMapMemoryBytes() const
+{
+    size_t res = nameMap.bucket_count() * sizeof(void*) + nameMap.size() * (sizeof(std::pair<const std::string, size_t>) + 2 * sizeof(void*));
+    for (const auto& [name, recordIdx] : nameMap)
+        res += heapBytes(name);
+    return res;
+}
+
+inline size_t Shape::typeHashMapMemoryBytes() const
+{
+    return typeHashMap.bucket_count() * sizeof(void*) + typeHashMap.size() * (sizeof(std::pair<const size_t, size_t>) + sizeof(void*));
+}
+
+inline size_t Shape::memoryBytes() const
+{
+    return sizeof(Shape) + namesMemoryBytes() + recordsMemoryBytes() + nameMapMemoryBytes() + typeHashMapMemoryBytes();
+}
+
+inline size_t Table::namesMemoryBytes() const
+{
+    return shape->namesMemoryBytes() / shapeShares() + heapBytes(spareNames);
+}
+
+inline size_t Table::recordsMemoryBytes() const
+{
+    return shape->recordsMemoryBytes() / shapeShares();
+}
+
+inline size_t Table::nameMapMemoryBytes() const
+{
+    size_t res = shape->nameMapMemoryBytes() / shapeShares();
+    res += spareNodes.capacity() * sizeof(StringMap<size_t>::node_type);
+    for (const StringMap<size_t>::node_type& node : spareNodes)
+        res += sizeof(std::pair<const std::string, size_t>) + 2 * sizeof(void*) + heapBytes(node.key());
+    return res;
+}
+
+inline size_t Table::typeHashMapMemoryBytes() const
+{
+    return shape->typeHashMapMemoryBytes() / shapeShares();
+}
+
+inline size_t Table::memoryBytes() const
+{
+    size_t res = namesMemoryBytes() + recordsMemoryBytes() + nameMapMemoryBytes() + typeHashMapMemoryBytes();
+    res += storages.capacity() * sizeof(ValueStorage*);
+    for (const ValueStorage* storage : storages)
+        res += storage->memoryUsage();
+    return res;
+}
+
+// Where the memory of a table goes, see Table::memoryUsage. All in bytes.
+struct MemoryUsage
+{
+    struct TypeUsage
+    {
+        const std::type_info* type = nullptr;
+        size_t bytes = 0; // the storage with its values, for tables without their contents (those are in subTables)
+    };
+    struct SubTableUsage;
+
+    // Shape parts are this table's share of the shape, see Table::shapeShares
+    size_t names = 0;       // the vector and the strings
+    size_t records = 0;     // records and the owners of the values
+    size_t nameMap = 0;     // nodes, buckets and the key strings
+    size_t typeHashMap = 0;
+    size_t shapeShares = 1; // tables using the same shape
+    size_t storageList = 0; // the vector of storage pointers
+    std::vector<TypeUsage> types;
+    std::vector<SubTableUsage> subTables;
+
+    // Without the nested tables
+    size_t own() const
+    {
+        size_t res = names + records + nameMap + typeHashMap + storageList;
+        for (const TypeUsage& type : types)
+            res += type.bytes;
+        return res;
+    }
+
+    size_t total() const;
+};
+
+struct MemoryUsage::SubTableUsage
+{
+    std::string name;
+    MemoryUsage usage;
+};
+
+inline size_t MemoryUsage::total() const
+{
+    size_t res = own();
+    for (const SubTableUsage& sub : subTables)
+        res += sub.usage.total();
+    return res;
+}
+
+inline MemoryUsage Table::memoryUsage() const
+{
+    MemoryUsage res;
+    res.names = namesMemoryBytes();
+    res.records = recordsMemoryBytes();
+    res.nameMap = nameMapMemoryBytes();
+    res.typeHashMap = typeHashMapMemoryBytes();
+    res.shapeShares = shapeShares();
+    res.storageList = storages.capacity() * sizeof(ValueStorage*);
+    for (size_t storageId = 0; storageId < storages.size(); ++storageId)
+    {
+        const ValueStorage* storage = storages[storageId];
+        MemoryUsage::TypeUsage typeUsage{&storage->type(), storage->memoryUsage()};
+        if (storage->type() == typeid(Table))
+        {
+            const TypedStorage<Table>* tstorage = (const TypedStorage<Table>*)storage;
+            for (size_t i = 0; i < tstorage->storage.size(); ++i)
+            {
+                MemoryUsage::SubTableUsage sub{shape->names[shape->nameIds[storageId][i]], tstorage->storage[i].memoryUsage()};
+                typeUsage.bytes -= sub.usage.total();
+                res.subTables.push_back(std::move(sub));
+            }
+        }
+        res.types.push_back(typeUsage);
+    }
+    return res;
+}
+
+template<typename T>
+inline void TypedStorage<T>::copyValueTo(size_t idx, const std::string_view& name, Table& dst) const
+{
+    dst.set<T>(name, T(storage[idx]));
+}
+
+template<>
+inline void TypedStorage<Table>::copyValueTo(size_t idx, const std::string_view& name, Table& dst) const
+{
+    dst.set<Table>(name, cloneTable(storage[idx]));
+}
+
 }
 
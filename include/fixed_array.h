@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+#include "edat.h"
+
+namespace edat
+{
+
+// Multi-dimensional arrays like `grid:float[64][64]` have at most that many dimensions
+static constexpr size_t fixedArrayMaxRank = 4;
+
+// Non-owning row-major view over a multi-dimensional array, a minimal std::mdspan.
+// view(y, x) is an element, view.slice(y) drops the first dimension (a row of a 2D array).
+template<typename T>
+struct MdView
+{
+    T* data = nullptr;
+    std::span<const size_t> extents;
+
+    size_t rank() const { return extents.size(); }
+    size_t extent(size_t dim) const { return extents[dim]; }
+    size_t size() const
+    {
+        size_t res = 1;
+        for (size_t extent : extents)
+            res *= extent;
+        return res;
+    }
+    std::span<T> values() const { return {data, size()}; }
+
+    // One index per dimension, slice() first for fewer
+    template<typename... Idx>
+    T& operator()(Idx... idx) const
+    {
+        static_assert(sizeof...(Idx) > 0 && sizeof...(Idx) <= fixedArrayMaxRank);
+        assert(sizeof...(Idx) == rank());
+        const size_t indices[] = {size_t(idx)...};
+        size_t offset = 0;
+        for (size_t dim = 0; dim < sizeof...(Idx); ++dim)
+            offset = offset * extents[dim] + indices[dim];
+        return data[offset];
+    }
+
+    MdView<T> slice(size_t idx) const
+    {
+        MdView<T> res;
+        res.extents = extents.subspan(1);
+        res.data = data + idx * res.size();
+        return res;
+    }
+};
+
+// Values of `type[N][M]...` in a single contiguous row-major buffer, see view().
+// Bools are packed into a BitVector like everywhere else, they have no view() and are read by value.
+template<typename T>
+struct FixedArray
+{
+    typename ValueContainer<T>::type data;
+    std::array<size_t, fixedArrayMaxRank> extents = {};
+    size_t rank = 0;
+
+    size_t size() const { return data.size(); }
+    size_t extent(size_t dim) const { return extents[dim]; }
+
+    MdView<const T> view() const requires (!std::is_same_v<T, bool>) { return {data.data(), std::span<const size_t>(extents.data(), rank)}; }
+    MdView<T> view() requires (!std::is_same_v<T, bool>) { return {data.data(), std::span<const size_t>(extents.data(), rank)}; }
+
+    // Row-major position of an element, one index per dimension
+    template<typename... Idx>
+    size_t offset(Idx... idx) const
+    {
+        static_assert(sizeof...(Idx) > 0 && sizeof...(Idx) <= fixedArrayMaxRank);
+        assert(sizeof...(Idx) == rank);
+        const size_t indices[] = {size_t(idx)...};
+        size_t res = 0;
+        for (size_t dim = 0; dim < sizeof...(Idx); ++dim)
+            res = res * extents[dim] + indices[dim];
+        return res;
+    }
+
+    // const T&, a plain bool for bools
+    template<typename... Idx>
+    decltype(auto) operator()(Idx... idx) const { return data[offset(idx...)]; }
+};
+
+template<typename T>
+inline size_t heapBytes(const FixedArray<T>& arr)
+{
+    return heapBytes(arr.data);
+}
+
+}
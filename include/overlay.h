@@ -0,0 +1,185 @@
+#pragma once
+
+#include <cstdint>
+#include "snapshot.h"
+
+namespace edat
+{
+
+// Bloom filter over the names of a table, about 1% false positives with 10 bits and 3 probes per key.
+// Probes are derived from the name's hash, so a lookup hashes the name once for all layers.
+struct NameFilter
+{
+    std::vector<uint64_t> bits;
+    size_t mask = 0;
+
+    static void probes(size_t hash, size_t (&res)[3])
+    {
+        const uint64_t h1 = uint64_t(hash);
+        const uint64_t h2 = (h1 >> 32 | h1 << 32) * 0x9e3779b97f4a7c15ull | 1;
+        for (size_t i = 0; i < 3; ++i)
+            res[i] = size_t(h1 + i * h2);
+    }
+
+    void build(const Table& tbl)
+    {
+        size_t bitCount = 64;
+        while (bitCount < tbl.shape->names.size() * 10)
+            bitCount *= 2;
+        bits.assign(bitCount / 64, 0);
+        mask = bitCount - 1;
+        for (const std::string& name : tbl.shape->names)
+        {
+            size_t positions[3];
+            probes(StringHash{}(name), positions);
+            for (size_t pos : positions)
+                bits[(pos & mask) / 64] |= uint64_t(1) << (pos & 63);
+        }
+    }
+
+    bool mayContain(size_t hash) const
+    {
+        size_t positions[3];
+        probes(hash, positions);
+        for (size_t pos : positions)
+            if (!(bits[(pos & mask) / 64] & (uint64_t(1) << (pos & 63))))
+                return false;
+        return true;
+    }
+};
+
+// Ordered chain of tables looked up as if they were merged, without merging them: layers pushed
+// later override the earlier ones (defaults first, most specific overrides last).
+// Each layer carries a NameFilter, so a key missing from a layer almost always costs a few bit tests
+// instead of a hash map probe.
+// Layers are referenced, not copied: plain tables have to outlive the overlay and must not get new keys
+// while they are in it (call rebuildFilters() if they do), snapshots are kept alive by the overlay.
+struct Overlay
+{
+    struct Layer
+    {
+        const Table* table = nullptr;
+        Snapshot owned;
+        NameFilter filter;
+    };
+
+    std::vector<Layer> layers;
+
+    void push(const Table& tbl)
+    {
+        Layer& layer = layers.emplace_back();
+        layer.table = &tbl;
+        layer.filter.build(tbl);
+    }
+
+    void push(Snapshot snapshot)
+    {
+        if (!snapshot)
+            return;
+        Layer& layer = layers.emplace_back();
+        layer.table = snapshot.table.get();
+        layer.owned = std::move(snapshot);
+        layer.filter.build(*layer.table);
+    }
+
+    void rebuildFilters()
+    {
+        for (Layer& layer : layers)
+            layer.filter.build(*layer.table);
+    }
+
+    // Topmost layer which has the key, nullptr if none does
+    const Table* findLayer(const std::string_view& name, Table::TableRecord& rec) const
+    {
+        const size_t hash = StringHash{}(name);
+        for (auto itl = layers.rbegin(); itl != layers.rend(); ++itl)
+        {
+            if (!itl->filter.mayContain(hash))
+                continue;
+            rec = itl->table->findIndex(name);
+            if (rec.storageId < itl->table->storages.size())
+                return itl->table;
+        }
+        return nullptr;
+    }
+
+    bool contains(const std::string_view& name) const
+    {
+        Table::TableRecord rec;
+        return findLayer(name, rec) != nullptr;
+    }
+
+    // The topmost layer having the key decides, if its value has another type `def` is returned
+    template<typename T>
+    T getOr(const std::string_view& name, T def) const
+    {
+        Table::TableRecord rec;
+        const Table* tbl = findLayer(name, rec);
+        if (tbl && rec.storageId == tbl->getStorageByType<T>())
+            return tbl->getTypedStorage<T>(rec.storageId)->storage[rec.idx];
+        return def;
+    }
+
+    template<typename T, typename Callable>
+    void get(const std::string_view& name, Callable c) const
+    {
+        Table::TableRecord rec;
+        const Table* tbl = findLayer(name, rec);
+        if (tbl && rec.storageId == tbl->getStorageByType<T>())
+            c(tbl->getTypedStorage<T>(rec.storageId)->storage[rec.idx]);
+    }
+
+    // Overlay of the subtables called `name` in every layer that has one, in the same order.
+    // Subtables of snapshot layers live in the snapshot, so their layers hold a reference to it too
+    // and the result can outlive this overlay.
+    Overlay sub(const std::string_view& name) const
+    {
+        Overlay res;
+        for (const Layer& layer : layers)
+        {
+            layer.table->get<Table>(name, [&](const Table& tbl)
+            {
+                Layer& child = res.layers.emplace_back();
+                child.table = &tbl;
+                child.owned = layer.owned;
+                child.filter.build(tbl);
+            });
+        }
+        return res;
+    }
+
+    // Materializes the chain into a single table, for when reads dominate.
+    // Subtables present in several layers are merged the same way as sub() sees them.
+    Table flatten() const
+    {
+        Table res;
+        for (const Layer& layer : layers)
+            mergeInto(res, *layer.table);
+        return res;
+    }
+
+    static void mergeInto(Table& dst, const Table& src)
+    {
+        const size_t srcTableStorage = src.getStorageByType<Table>();
+        for (const Table::TableRecord& rec : src.shape->records)
+        {
+            if (rec.storageId >= src.storages.size())
+                continue;
+            const std::string& name = src.shape->names[rec.nameId];
+            if (rec.storageId == srcTableStorage)
+            {
+                const Table::TableRecord dstRec = dst.findIndex(name);
+                if (dstRec.storageId < dst.storages.size() && dstRec.storageId == dst.getStorageByType<Table>())
+                {
+                    mergeInto(dst.getTypedStorage<Table>(dstRec.storageId)->storage[dstRec.idx],
+                              src.getTypedStorage<Table>(rec.storageId)->storage[rec.idx]);
+                    continue;
+                }
+            }
+            src.storages[rec.storageId]->copyValueTo(rec.idx, name, dst);
+        }
+    }
+};
+
+}
+
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace edat
+{
+
+// Runs fn(i) for every i in [0, count) on `threads` threads, the calling thread included.
+// Every thread starts with its own contiguous range of indices and takes work from its front.
+// Once it runs dry it steals the back half of another thread's range, so a few expensive items
+// don't leave the rest of the threads idle. Ranges are packed into a single 64 bit word, so both
+// taking and stealing are a single CAS.
+// If fn throws, the remaining items are still processed and the first exception is rethrown here.
+template<typename Callable>
+void parallelFor(size_t count, size_t threads, Callable fn)
+{
+    assert(count < (uint64_t(1) << 32));
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min(threads, count));
+    if (threads == 1)
+    {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+        return;
+    }
+
+    auto pack = [](uint64_t begin, uint64_t end) { return (begin << 32) | end; };
+    auto rangeBegin = [](uint64_t range) { return range >> 32; };
+    auto rangeEnd = [](uint64_t range) { return range & 0xffffffffu; };
+
+    // Separate cache lines, otherwise every CAS would bounce the neighbours' ranges around
+    struct alignas(64) Range
+    {
+        std::atomic<uint64_t> range;
+    };
+    std::vector<Range> ranges(threads);
+    for (size_t t = 0; t < threads; ++t)
+        ranges[t].range = pack(count * t / threads, count * (t + 1) / threads);
+
+    std::mutex exceptionMutex;
+    std::exception_ptr firstException;
+
+    auto worker = [&](size_t self)
+    {
+        while (true)
+        {
+            // Take from the front of our own range
+            uint64_t range = ranges[self].range.load();
+            while (rangeBegin(range) < rangeEnd(range))
+            {
+                if (!ranges[self].range.compare_exchange_weak(range, pack(rangeBegin(range) + 1, rangeEnd(range))))
+                    continue;
+                try
+                {
+                    fn(rangeBegin(range));
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if (!firstException)
+                        firstException = std::current_exception();
+                }
+                range = ranges[self].range.load();
+            }
+
+            // Ours is empty, steal the back half of someone else's
+            bool stole = false;
+            for (size_t i = 1; i < threads && !stole; ++i)
+            {
+                Range& victim = ranges[(self + i) % threads];
+                uint64_t victimRange = victim.range.load();
+                while (rangeBegin(victimRange) < rangeEnd(victimRange))
+                {
+                    uint64_t begin = rangeBegin(victimRange);
+                    uint64_t end = rangeEnd(victimRange);
+                    uint64_t split = begin + (end - begin) / 2;
+                    if (victim.range.compare_exchange_weak(victimRange, pack(begin, split)))
+                    {
+                        // Nobody else can see these indices until we publish them as our range
+                        ranges[self].range.store(pack(split, end));
+                        stole = true;
+                        break;
+                    }
+                }
+            }
+            if (!stole)
+                return;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < threads; ++t)
+        workers.emplace_back(worker, t);
+    worker(0);
+    for (std::thread& thread : workers)
+        thread.join();
+
+    if (firstException)
+        std::rethrow_exception(firstException);
+}
+
+}
+
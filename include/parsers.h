@@ -2,18 +2,85 @@
 
 #include <functional>
 #include <filesystem>
+#include <span>
+#include <chrono>
+#include <cstdio>
 #include "edat.h"
+#include "fixed_array.h"
+#include "perfect_hash.h"
 
 namespace edat
 {
 
+// What a parse did and where the time went, filled by parseString/parseFile when asked to.
+// Without a ParseStats the parser is compiled without any of the accounting.
+struct ParseStats
+{
+    using Clock = std::chrono::steady_clock;
+
+    uint64_t bytesScanned = 0;
+    uint64_t keys = 0;          // every entry, values and tables
+    uint64_t tables = 0;        // nested tables
+    uint64_t arrays = 0;
+    StringMap<uint64_t> valuesPerType; // by type name, array elements count one each
+    uint64_t clones = 0;        // cloneTable calls for `<-`
+    uint64_t bytesCopied = 0;   // memory of the cloned tables, see Table::memoryBytes
+
+    double ioSeconds = 0.0;
+    double scanSeconds = 0.0;       // everything that isn't one of the others: tokenizing, skipping whitespace, errors
+    double conversionSeconds = 0.0; // string to value, by the type parsers
+    double insertionSeconds = 0.0;  // Table::set of values and finished subtables
+    double cloneSeconds = 0.0;
+
+    static double secondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+};
+
+// Human readable summary on stdout
+void printParseStats(const ParseStats& stats);
+
 struct TypeParser
 {
     size_t typeId; // C++ type id for validation?
+    // Parsers with a closed set of values (enums) set this and reject the others in acceptsValue, the parse then
+    // fails with an error at the value instead of storing a made up one. Off by default, it costs a call per value.
+    bool checksValues = false;
 
     virtual ~TypeParser() {};
+    virtual bool acceptsValue(const std::string_view& /*str*/) const { return true; }
     virtual void parseValue(const std::string_view& name, const std::string_view& str, Table& res) const = 0;
     virtual void parseArray(const std::string_view& name, const std::vector<std::string_view>& strings, Table& res) const = 0;
+    // Arrays with several dimensions (`float[4][4]`), `strings` are row-major and their count matches the extents.
+    // Parsers without support for them store the values as a plain array.
+    virtual void parseFixedArray(const std::string_view& name, const std::vector<std::string_view>& strings,
+                                 std::span<const size_t> /*extents*/, Table& res) const
+    {
+        parseArray(name, strings, res);
+    }
+
+    // Used instead of the above when collecting ParseStats, these account conversion and insertion separately.
+    // Parsers that don't override them have the whole call accounted as conversion.
+    virtual void parseValueTimed(const std::string_view& name, const std::string_view& str, Table& res, ParseStats& stats) const
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        parseValue(name, str, res);
+        stats.conversionSeconds += ParseStats::secondsSince(start);
+    }
+    virtual void parseArrayTimed(const std::string_view& name, const std::vector<std::string_view>& strings, Table& res, ParseStats& stats) const
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        parseArray(name, strings, res);
+        stats.conversionSeconds += ParseStats::secondsSince(start);
+    }
+    virtual void parseFixedArrayTimed(const std::string_view& name, const std::vector<std::string_view>& strings,
+                                      std::span<const size_t> extents, Table& res, ParseStats& stats) const
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        parseFixedArray(name, strings, extents, res);
+        stats.conversionSeconds += ParseStats::secondsSince(start);
+    }
 };
 
 template<typename T>
@@ -31,16 +98,137 @@ struct LambdaParser : public TypeParser
     }
     void parseArray(const std::string_view& name, const std::vector<std::string_view>& strings, Table& res) const final
     {
-        std::vector<T> arr;
+        typename ValueContainer<T>::type arr; // bool[] is a BitVector
+        arr.reserve(strings.size());
         for (const std::string_view& str : strings)
             arr.push_back(parseValueLambda(str));
-        res.set<std::vector<T>>(name, std::move(arr));
+        res.set<typename ValueContainer<T>::type>(name, std::move(arr));
+    }
+    void parseFixedArray(const std::string_view& name, const std::vector<std::string_view>& strings,
+                         std::span<const size_t> extents, Table& res) const final
+    {
+        res.set<FixedArray<T>>(name, convertFixedArray(strings, extents));
+    }
+
+    FixedArray<T> convertFixedArray(const std::vector<std::string_view>& strings, std::span<const size_t> extents) const
+    {
+        FixedArray<T> arr;
+        arr.rank = extents.size();
+        std::copy(extents.begin(), extents.end(), arr.extents.begin());
+        arr.data.reserve(strings.size());
+        for (const std::string_view& str : strings)
+            arr.data.push_back(parseValueLambda(str));
+        return arr;
+    }
+
+    void parseValueTimed(const std::string_view& name, const std::string_view& str, Table& res, ParseStats& stats) const final
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        T value = parseValueLambda(str);
+        ParseStats::Clock::time_point converted = ParseStats::Clock::now();
+        res.set<T>(name, std::move(value));
+        stats.conversionSeconds += std::chrono::duration<double>(converted - start).count();
+        stats.insertionSeconds += ParseStats::secondsSince(converted);
+    }
+    void parseArrayTimed(const std::string_view& name, const std::vector<std::string_view>& strings, Table& res, ParseStats& stats) const final
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        typename ValueContainer<T>::type arr;
+        arr.reserve(strings.size());
+        for (const std::string_view& str : strings)
+            arr.push_back(parseValueLambda(str));
+        ParseStats::Clock::time_point converted = ParseStats::Clock::now();
+        res.set<typename ValueContainer<T>::type>(name, std::move(arr));
+        stats.conversionSeconds += std::chrono::duration<double>(converted - start).count();
+        stats.insertionSeconds += ParseStats::secondsSince(converted);
+    }
+    void parseFixedArrayTimed(const std::string_view& name, const std::vector<std::string_view>& strings,
+                              std::span<const size_t> extents, Table& res, ParseStats& stats) const final
+    {
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        FixedArray<T> arr = convertFixedArray(strings, extents);
+        ParseStats::Clock::time_point converted = ParseStats::Clock::now();
+        res.set<FixedArray<T>>(name, std::move(arr));
+        stats.conversionSeconds += std::chrono::duration<double>(converted - start).count();
+        stats.insertionSeconds += ParseStats::secondsSince(converted);
     }
 };
 
+// Enum types: values are one of a fixed set of names, stored as compact integers of type T
+// (a C++ enum or an integer type) instead of strings. Names are looked up with a perfect hash built
+// when the type is registered, so parsing a value is two hashes and one string compare.
+//   enum class Blend : uint8_t { Opaque, Additive, Multiply };
+//   psuite.addEnum<Blend>("blend", {{"opaque", Blend::Opaque}, {"additive", Blend::Additive}, {"multiply", Blend::Multiply}});
+//   mode:blend = "additive"
+// A value that isn't one of the names is a parse error reported at the value, like any other malformed entry,
+// nothing is stored for it. name() maps values back for writing them out.
+template<typename T>
+struct EnumParser : public LambdaParser<T>
+{
+    std::string typeName;
+    std::vector<std::string> names;
+    std::vector<T> values; // parallel to names
+    PerfectHash lookup;
+    bool uniqueNames = true; // false if a name was given twice, ParserSuite::addEnum doesn't register such enums
+
+    EnumParser(const std::string_view& typeName, std::span<const std::pair<std::string_view, T>> entries)
+        : LambdaParser<T>([this](const std::string_view& str) { return parse(str); }), typeName(typeName)
+    {
+        this->checksValues = true;
+        for (const auto& [name, value] : entries)
+        {
+            names.emplace_back(name);
+            values.push_back(value);
+        }
+        uniqueNames = lookup.build(names);
+    }
+    // The lambda points back at this parser
+    EnumParser(const EnumParser&) = delete;
+    EnumParser& operator=(const EnumParser&) = delete;
+
+    // The value named `str`, nullptr if there's no such name
+    const T* find(const std::string_view& str) const
+    {
+        const uint32_t idx = lookup.candidate(str);
+        return idx != PerfectHash::none && names[idx] == str ? &values[idx] : nullptr;
+    }
+
+    bool acceptsValue(const std::string_view& str) const final { return find(str) != nullptr; }
+
+    // T{} for unknown names, those never get here from a parse (see acceptsValue)
+    T parse(const std::string_view& str) const
+    {
+        const T* value = find(str);
+        return value ? *value : T{};
+    }
+
+    // Name of `value`, empty if it isn't one of the enum's values. A linear search, enums are short.
+    std::string_view name(T value) const
+    {
+        for (size_t i = 0; i < values.size(); ++i)
+            if (values[i] == value)
+                return names[i];
+        return {};
+    }
+};
+
+// Values of a bool parser: true/false, 1/0, yes/no or on/off, anything else is false.
+//   psuite.addLambdaParser<bool>("bool", edat::parseBool);
+bool parseBool(const std::string_view& str);
+
+// Register all the parsers first, after that the suite is read-only and a single instance
+// can be shared by any number of threads parsing at the same time (see parseFiles).
+// Parsers themselves have to be stateless for that, LambdaParser is as long as its lambda is.
 struct ParserSuite
 {
-    std::unordered_map<std::string, TypeParser*> typeParsers;
+    StringMap<TypeParser*> typeParsers;
+    // Applied to every parsed table with Table::optimizeLayout if not empty, see loadProfile
+    AccessProfile layoutProfile;
+
+    ParserSuite() = default;
+    // Owns the parsers, copying would delete them twice
+    ParserSuite(const ParserSuite&) = delete;
+    ParserSuite& operator=(const ParserSuite&) = delete;
 
     ~ParserSuite()
     {
@@ -48,9 +236,21 @@ struct ParserSuite
             delete parser;
     }
 
+    // Replaces the parser if the type was registered already
     void addParser(const std::string_view& typeName, TypeParser* parser)
     {
-        typeParsers.emplace(typeName, parser);
+        auto [itf, inserted] = typeParsers.emplace(typeName, parser);
+        if (!inserted)
+        {
+            delete itf->second;
+            itf->second = parser;
+        }
+    }
+
+    const TypeParser* findParser(const std::string_view& typeName) const
+    {
+        auto itf = typeParsers.find(typeName);
+        return itf != typeParsers.end() ? itf->second : nullptr;
     }
 
     template<typename T, typename Callable>
@@ -59,10 +259,66 @@ struct ParserSuite
         LambdaParser<T>* parser = new LambdaParser<T>(c);
         addParser(typeName, parser);
     }
+
+    // See EnumParser. Returns false (and reports it) if a name is given twice, the type isn't registered then.
+    template<typename T>
+    bool addEnum(const std::string_view& typeName, std::initializer_list<std::pair<std::string_view, T>> entries)
+    {
+        EnumParser<T>* parser = new EnumParser<T>(typeName, std::span(entries.begin(), entries.size()));
+        if (!parser->uniqueNames)
+        {
+            printf("Error: enum %.*s has duplicate names\n", (int)typeName.size(), typeName.data());
+            delete parser;
+            return false;
+        }
+        addParser(typeName, parser);
+        return true;
+    }
+
+    // The enum registered as `typeName` with values of type T, nullptr if there's no such enum
+    template<typename T>
+    const EnumParser<T>* findEnum(const std::string_view& typeName) const
+    {
+        return dynamic_cast<const EnumParser<T>*>(findParser(typeName));
+    }
 };
 
-edat::Table parseString(const std::string& input, const ParserSuite& psuite);
-edat::Table parseFile(std::filesystem::path path, const ParserSuite& psuite);
+// Parses a document a few top level entries at a time, for callers that can't afford to block
+// for the whole parse (see parseFileAsync). The input has to outlive the parser.
+struct IncrementalParser
+{
+    std::string_view view;
+    const char* lineStart = nullptr;
+    const ParserSuite& psuite;
+    edat::Table result;
+    ShapeRegistry shapes; // of the subtables parsed so far
+    bool done = false;
+
+    IncrementalParser(std::string_view input, const ParserSuite& psuite);
+
+    // Parses entries until at least `budget` bytes are consumed, returns false once the whole input is parsed.
+    // Entries are never split, so a huge subtable is still parsed in one go.
+    bool step(size_t budget);
+};
+
+// With `stats` the parse also fills it in (adding to what's there already)
+edat::Table parseString(const std::string& input, const ParserSuite& psuite, ParseStats* stats = nullptr);
+// Same, but returns false if the input has errors (they're reported as usual), `out` then has the entries
+// parsed before the first one. For callers that must not use a partial table, e.g. reloads of a live config.
+bool tryParseString(const std::string& input, const ParserSuite& psuite, edat::Table& out, ParseStats* stats = nullptr);
+edat::Table parseFile(std::filesystem::path path, const ParserSuite& psuite, ParseStats* stats = nullptr);
+
+// Parses all the files concurrently on `threads` threads (0 means one per core) sharing the same suite.
+// Tables are returned in the same order as paths, files that can't be read result in empty tables.
+std::vector<edat::Table> parseFiles(std::span<const std::filesystem::path> paths, const ParserSuite& psuite, size_t threads = 0);
+
+// Reads the whole file into `out`, returns false (and reports it) if the file can't be opened
+bool readFile(const std::filesystem::path& path, std::string& out);
+
+// Access profiles as text, a `hits path` pair per line. Loading adds to what `profile` has already.
+// E.g. profile a run, save it, and at the next start load it into ParserSuite::layoutProfile.
+bool saveProfile(const AccessProfile& profile, const std::filesystem::path& path);
+bool loadProfile(const std::filesystem::path& path, AccessProfile& profile);
 
 }
 
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace edat
+{
+
+// Collision free hash over a fixed set of keys (hash and displace): keys are split in buckets by a first hash,
+// and every bucket gets the seed that places all of its keys in free slots. A lookup is then two hashes and
+// a single string compare against the only key that can match, no probing.
+// Built once when the key set is known, e.g. the names of an enum type.
+struct PerfectHash
+{
+    static constexpr uint32_t none = ~uint32_t(0);
+
+    std::vector<uint32_t> seeds; // per bucket
+    std::vector<uint32_t> slots; // index of the key in each slot, `none` for empty ones
+    uint64_t slotMask = 0;
+
+    // Seeded FNV-1a with a final mix, the low bits are used as slot and bucket indices
+    static uint64_t hash(const std::string_view& str, uint64_t seed)
+    {
+        uint64_t res = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (char ch : str)
+        {
+            res ^= (unsigned char)ch;
+            res *= 1099511628211ull;
+        }
+        res ^= res >> 33;
+        res *= 0xFF51AFD7ED558CCDull;
+        res ^= res >> 33;
+        return res;
+    }
+
+    // Keys have to be unique, returns false if they aren't
+    bool build(std::span<const std::string> keys);
+
+    // Index of the only key that can be equal to `str` (compare it), `none` if there's none
+    uint32_t candidate(const std::string_view& str) const
+    {
+        if (seeds.empty())
+            return none;
+        const uint32_t seed = seeds[hash(str, 0) % seeds.size()];
+        return slots[hash(str, seed) & slotMask];
+    }
+
+    size_t memoryBytes() const { return seeds.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(uint32_t); }
+};
+
+inline bool PerfectHash::build(std::span<const std::string> keys)
+{
+    seeds.clear();
+    slots.clear();
+    slotMask = 0;
+    if (keys.empty())
+        return true;
+    for (size_t i = 0; i < keys.size(); ++i)
+        for (size_t j = i + 1; j < keys.size(); ++j)
+            if (keys[i] == keys[j])
+                return false;
+
+    // About 4 keys per bucket, biggest buckets placed first while most slots are free
+    const size_t bucketCount = (keys.size() + 3) / 4;
+    std::vector<std::vector<uint32_t>> buckets(bucketCount);
+    for (size_t i = 0; i < keys.size(); ++i)
+        buckets[hash(keys[i], 0) % bucketCount].push_back((uint32_t)i);
+    std::vector<uint32_t> order(bucketCount);
+    for (size_t i = 0; i < bucketCount; ++i)
+        order[i] = (uint32_t)i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+    // A power of two at least twice the key count keeps the seed search short, more room if a bucket can't be placed
+    size_t slotCount = std::bit_ceil(keys.size() * 2);
+    for (;;)
+    {
+        seeds.assign(bucketCount, 0);
+        slots.assign(slotCount, none);
+        slotMask = slotCount - 1;
+        bool placedAll = true;
+        std::vector<uint64_t> placed;
+        for (uint32_t bucket : order)
+        {
+            bool found = false;
+            for (uint32_t seed = 1; seed < 4096 && !found; ++seed)
+            {
+                placed.clear();
+                found = true;
+                for (uint32_t key : buckets[bucket])
+                {
+                    const uint64_t slot = hash(keys[key], seed) & slotMask;
+                    if (slots[slot] != none || std::find(placed.begin(), placed.end(), slot) != placed.end())
+                    {
+                        found = false;
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+                if (found)
+                {
+                    seeds[bucket] = seed;
+                    for (size_t i = 0; i < placed.size(); ++i)
+                        slots[placed[i]] = buckets[bucket][i];
+                }
+            }
+            if (!found)
+            {
+                placedAll = false;
+                break;
+            }
+        }
+        if (placedAll)
+            return true;
+        slotCount *= 2;
+    }
+}
+
+}
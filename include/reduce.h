@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <execution>
+#include <numeric>
+#include <optional>
+#include "edat.h"
+
+namespace edat
+{
+
+// Bulk reductions over Table::view<T>(). They take the standard execution policies, the default
+// par_unseq splits the work across cores and lets each chunk vectorize.
+
+template<typename T, typename Policy>
+T sum(Policy&& policy, const TypedView<T>& view)
+{
+    return std::reduce(policy, view.values.begin(), view.values.end(), T{});
+}
+
+template<typename T>
+T sum(const TypedView<T>& view)
+{
+    return sum(std::execution::par_unseq, view);
+}
+
+// nullopt for empty views
+template<typename T, typename Policy>
+std::optional<T> min(Policy&& policy, const TypedView<T>& view)
+{
+    auto itf = std::min_element(policy, view.values.begin(), view.values.end());
+    if (itf == view.values.end())
+        return std::nullopt;
+    return *itf;
+}
+
+template<typename T>
+std::optional<T> min(const TypedView<T>& view)
+{
+    return min(std::execution::par_unseq, view);
+}
+
+template<typename T, typename Policy>
+std::optional<T> max(Policy&& policy, const TypedView<T>& view)
+{
+    auto itf = std::max_element(policy, view.values.begin(), view.values.end());
+    if (itf == view.values.end())
+        return std::nullopt;
+    return *itf;
+}
+
+template<typename T>
+std::optional<T> max(const TypedView<T>& view)
+{
+    return max(std::execution::par_unseq, view);
+}
+
+template<typename T, typename Policy, typename Predicate>
+size_t count(Policy&& policy, const TypedView<T>& view, Predicate pred)
+{
+    return size_t(std::count_if(policy, view.values.begin(), view.values.end(), pred));
+}
+
+template<typename T, typename Predicate>
+size_t count(const TypedView<T>& view, Predicate pred)
+{
+    return count(std::execution::par_unseq, view, pred);
+}
+
+// `bins` equal-width buckets over [lo, hi), values outside of the range (and NaNs) aren't counted.
+// Every chunk of values fills a private histogram, those are summed at the end, so there are no atomics
+// in the inner loop.
+template<typename T, typename Policy>
+std::vector<size_t> histogram(Policy&& policy, const TypedView<T>& view, T lo, T hi, size_t bins)
+{
+    std::vector<size_t> res(bins, 0);
+    if (bins == 0 || !(lo < hi) || view.values.empty())
+        return res;
+
+    constexpr size_t chunkSize = 16 * 1024;
+    const size_t chunkCount = (view.values.size() + chunkSize - 1) / chunkSize;
+    std::vector<size_t> partial(chunkCount * bins, 0);
+    std::vector<size_t> chunks(chunkCount);
+    std::iota(chunks.begin(), chunks.end(), size_t(0));
+
+    const double scale = double(bins) / (double(hi) - double(lo));
+    std::for_each(policy, chunks.begin(), chunks.end(), [&](size_t chunk)
+    {
+        size_t* counts = partial.data() + chunk * bins;
+        const size_t end = std::min(view.values.size(), (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; ++i)
+        {
+            const T val = view.values[i];
+            if (!(val >= lo && val < hi))
+                continue;
+            counts[std::min(bins - 1, size_t((double(val) - double(lo)) * scale))]++;
+        }
+    });
+
+    for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+        for (size_t bin = 0; bin < bins; ++bin)
+            res[bin] += partial[chunk * bins + bin];
+    return res;
+}
+
+template<typename T>
+std::vector<size_t> histogram(const TypedView<T>& view, T lo, T hi, size_t bins)
+{
+    return histogram(std::execution::par_unseq, view, lo, hi, bins);
+}
+
+}
+
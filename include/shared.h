@@ -0,0 +1,258 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <thread>
+#include <utility>
+#include "edat.h"
+
+namespace edat
+{
+
+// Relocatable binary form of a Table: everything is addressed by offsets from the start of the
+// buffer, so it can be mapped at any address in any process and read in place.
+// Supported value types are int, float, bool, std::string, arrays and fixed arrays of those, nested tables
+// and arrays of tables. Tables with anything else (enums, custom types) can't be serialized at all.
+namespace flat
+{
+
+// Offsets of names, string lengths, array sizes and entry counts are 32 bit
+static constexpr uint64_t maxFieldValue = UINT32_MAX;
+// So no serialized table is ever bigger than this, the first name past it would be out of reach
+static constexpr uint64_t maxBufferSize = uint64_t(UINT32_MAX) + 1;
+
+enum class ValueType : uint32_t
+{
+    Int,
+    Float,
+    String,
+    IntArray,
+    FloatArray,
+    StringArray,
+    Table,
+    Bool,
+    BoolArray,  // count bits, payload points at the 64 bit words
+    FixedArray, // count is the rank, payload points at a FixedArrayHeader
+    TableArray  // count tables, payload points at their offsets (uint64_t each)
+};
+
+struct Entry
+{
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    ValueType type;
+    uint32_t count;   // string length or array size
+    uint64_t payload; // value itself for int and float, offset of the data otherwise
+};
+
+// Values of a fixed array are stored like a plain array of elementType
+struct FixedArrayHeader
+{
+    ValueType elementType;
+    uint32_t rank;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t payload;
+    uint64_t extents[4];
+};
+
+struct StringRef
+{
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Entries follow the header, sorted by name
+struct TableHeader
+{
+    uint32_t entryCount;
+    uint32_t reserved;
+};
+
+}
+
+// Serializes the table into `out` (replacing its contents), the first 8 bytes hold the offset of the root table.
+// Returns false (and reports why, leaving `out` empty) if the table doesn't fit the format's 32 bit fields
+// or has values of a type the format can't hold.
+bool serializeFlat(const Table& tbl, std::vector<char>& out);
+
+// Read-only accessor over a serialized table. Every offset is checked against the buffer size,
+// so a torn or corrupted buffer yields missing values rather than out of bounds reads.
+struct FlatView
+{
+    const char* base = nullptr;
+    size_t size = 0;
+    size_t tableOffset = 0;
+
+    FlatView() = default;
+    FlatView(const char* base, size_t size, size_t tableOffset = 0) : base(base), size(size), tableOffset(tableOffset) {}
+
+    // Entries from a single read of the table header, the buffer may be rewritten concurrently (see SharedReader::read)
+    std::span<const flat::Entry> entries() const;
+    size_t entryCount() const;
+    const flat::Entry* entry(size_t idx) const;
+    const flat::Entry* find(const std::string_view& name) const;
+    std::string_view entryName(const flat::Entry& e) const;
+
+    std::optional<int> getInt(const std::string_view& name) const;
+    std::optional<float> getFloat(const std::string_view& name) const;
+    std::optional<bool> getBool(const std::string_view& name) const;
+    std::optional<std::string_view> getString(const std::string_view& name) const;
+    std::optional<std::span<const int>> getIntArray(const std::string_view& name) const;
+    std::optional<std::span<const float>> getFloatArray(const std::string_view& name) const;
+    std::optional<FlatView> getTable(const std::string_view& name) const;
+
+    // Same semantics as Table::getOr for int, float, bool and std::string
+    template<typename T>
+    T getOr(const std::string_view& name, T def) const
+    {
+        if constexpr (std::is_same_v<T, int>)
+            return getInt(name).value_or(def);
+        else if constexpr (std::is_same_v<T, float>)
+            return getFloat(name).value_or(def);
+        else if constexpr (std::is_same_v<T, bool>)
+            return getBool(name).value_or(def);
+        else if constexpr (std::is_same_v<T, std::string>)
+        {
+            std::optional<std::string_view> str = getString(name);
+            return str ? std::string(*str) : def;
+        }
+        else
+            static_assert(sizeof(T) == 0, "FlatView::getOr supports int, float, bool and std::string");
+    }
+
+    // Converts back into a regular Table
+    Table toTable() const;
+};
+
+// Layout of the shared memory object: a control block followed by two data slots.
+// The publisher always writes into the slot readers aren't directed to, then flips activeSlot.
+// Each slot has its own sequence counter (odd while being written) so a reader that was slow
+// enough for the slot to get reused notices and retries.
+struct SharedControlBlock
+{
+    static constexpr uint64_t magicValue = 0x3130544144454445ull; // "EDEDAT01"
+    static constexpr size_t slotCount = 2;
+
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        std::atomic<uint64_t> size;
+    };
+
+    uint64_t magic;
+    uint64_t slotCapacity;
+    std::atomic<uint64_t> generation;
+    std::atomic<uint32_t> activeSlot;
+    uint32_t reserved;
+    Slot slots[slotCount];
+
+    static size_t slotOffset(size_t slot, size_t capacity)
+    {
+        return ((sizeof(SharedControlBlock) + 63) & ~size_t(63)) + slot * capacity;
+    }
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory publication needs lock-free 64 bit atomics");
+
+// Creates (or takes over) a POSIX shared memory object and publishes tables into it.
+// `name` follows shm_open rules, i.e. "/something". `capacity` is per slot, tables that serialize
+// into more than that are rejected. Capacities over flat::maxBufferSize are rejected (isValid() is false).
+// An object that's initialized already may have readers attached, it's reused as it is (its slots keep
+// their capacity, which may be bigger than asked for) and never reset or shrunk. If its slots are smaller
+// than `capacity` the publisher fails instead, unlink the object first to start over.
+struct SharedPublisher
+{
+    std::string name;
+    size_t capacity = 0;
+    size_t mappedSize = 0;
+    char* mapping = nullptr;
+    std::vector<char> buffer;
+
+    SharedPublisher(std::string name, size_t capacity);
+    ~SharedPublisher();
+
+    SharedPublisher(const SharedPublisher&) = delete;
+    SharedPublisher& operator=(const SharedPublisher&) = delete;
+
+    bool isValid() const { return mapping != nullptr; }
+    bool publish(const Table& tbl);
+    // Removes the name, processes that already attached keep their mapping
+    void unlink();
+};
+
+// Attaches to a publisher's shared memory read-only. Memory is shared with every other process,
+// reading the latest version is a load of the active slot index.
+struct SharedReader
+{
+    size_t mappedSize = 0;
+    const char* mapping = nullptr;
+
+    explicit SharedReader(const std::string& name);
+    ~SharedReader();
+
+    SharedReader(const SharedReader&) = delete;
+    SharedReader& operator=(const SharedReader&) = delete;
+
+    bool isValid() const { return mapping != nullptr; }
+    const SharedControlBlock& control() const { return *(const SharedControlBlock*)mapping; }
+    uint64_t generation() const { return control().generation.load(std::memory_order_acquire); }
+
+    // Calls c(const FlatView&) on a consistent version of the table and returns its result.
+    // The callable may be called again if a publish raced with it, so it should only copy values out
+    // and not keep pointers into the view.
+    // Returns nullopt if no consistent version could be read within `timeout`, e.g. the slot stays marked
+    // as being written because the publisher died mid-write, or publishes keep racing with a slow reader.
+    template<typename Callable>
+    auto read(Callable c, std::chrono::milliseconds timeout = std::chrono::milliseconds(100)) const
+        -> std::optional<decltype(c(std::declval<const FlatView&>()))>
+    {
+        const SharedControlBlock& ctrl = control();
+        // The clock is only looked at once the first attempt failed
+        std::chrono::steady_clock::time_point deadline;
+        for (size_t attempt = 0;; ++attempt)
+        {
+            if (attempt == 1)
+                deadline = std::chrono::steady_clock::now() + timeout;
+            else if (attempt > 1)
+            {
+                if (std::chrono::steady_clock::now() > deadline)
+                    return std::nullopt;
+                std::this_thread::yield();
+            }
+            const uint32_t slot = ctrl.activeSlot.load(std::memory_order_acquire) % SharedControlBlock::slotCount;
+            const SharedControlBlock::Slot& header = ctrl.slots[slot];
+            const uint64_t sequence = header.sequence.load(std::memory_order_acquire);
+            if (sequence & 1)
+                continue;
+            const size_t size = std::min<size_t>(header.size.load(std::memory_order_relaxed), ctrl.slotCapacity);
+            FlatView view(mapping + SharedControlBlock::slotOffset(slot, ctrl.slotCapacity), size);
+            auto res = c(std::as_const(view));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (header.sequence.load(std::memory_order_relaxed) == sequence)
+                return res;
+        }
+    }
+
+    // `def` also if no consistent version could be read
+    template<typename T>
+    T getOr(const std::string_view& name, T def) const
+    {
+        std::optional<T> res = read([&](const FlatView& view) { return view.getOr<T>(name, def); });
+        return res ? std::move(*res) : def;
+    }
+
+    // Empty table if no consistent version could be read
+    Table toTable() const
+    {
+        std::optional<Table> res = read([](const FlatView& view) { return view.toTable(); });
+        return res ? std::move(*res) : Table{};
+    }
+};
+
+}
+
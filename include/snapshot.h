@@ -0,0 +1,59 @@
+#pragma once
+
+#include <memory>
+#include "edat.h"
+
+namespace edat
+{
+
+// Immutable reference-counted Table.
+// Nothing reachable from a Snapshot can be modified (nested tables included, as they are only
+// handed out by const reference), so any number of threads can read it without synchronization.
+// Copying a Snapshot just bumps the refcount, the table is freed when the last copy goes away.
+//
+// Threading contract of Table itself: a table is not synchronized, it's either read by any number of threads
+// or modified by one with no readers. Different tables can be used on different threads freely, even when
+// they share a Shape (copies, tables parsed from the same layout): a table that modifies its keys copies the
+// shape first unless it's the only user left (Table::ownsShape), so shared shapes are never written to.
+struct Snapshot
+{
+    std::shared_ptr<const Table> table;
+
+    Snapshot() = default;
+    explicit Snapshot(Table&& tbl) : table(std::make_shared<const Table>(std::move(tbl))) {}
+
+    explicit operator bool() const { return table != nullptr; }
+    const Table& operator*() const { return *table; }
+    const Table* operator->() const { return table.get(); }
+
+    template<typename T>
+    T getOr(const std::string_view& name, T def) const
+    {
+        if (!table)
+            return def;
+        return table->getOr<T>(name, std::move(def));
+    }
+
+    template<typename T, typename Callable>
+    void get(const std::string_view& name, Callable c) const
+    {
+        if (table)
+            table->get<T>(name, c);
+    }
+
+    template<typename T, typename Callable>
+    void getAll(Callable c) const
+    {
+        if (table)
+            table->getAll<T>(c);
+    }
+};
+
+// Deep copies the table, the source can be modified afterwards without affecting the snapshot
+inline Snapshot makeSnapshot(const Table& tbl)
+{
+    return Snapshot(cloneTable(tbl));
+}
+
+}
+
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "edat.h"
+
+namespace edat
+{
+
+// Array of tables, `items:table[] = [ { ... }, { ... } ]` in a document.
+// When all the elements have the same shape (same keys of the same types) they are stored column-wise:
+// one contiguous typed column per key with the values of every element, so scanning a single key over
+// all the items is a linear read (see column()). Otherwise the elements are kept as separate tables in `rows`.
+//
+//   tbl.get<edat::TableArray>("items", [](const edat::TableArray& items)
+//   {
+//       for (float weight : items.column<float>("weight"))
+//           ...
+//   });
+struct TableArray
+{
+    // Shape of every element, nullptr if the elements are stored as rows
+    std::shared_ptr<Shape> shape;
+    // Parallel to shape->records, the values of all the elements under that key (nullptr for erased keys)
+    std::vector<ValueStorage*> columns;
+    // Empty storage per storage of the shape, to build elements from columns
+    std::vector<ValueStorage*> storageTypes;
+    std::vector<Table> rows;
+    size_t count = 0;
+
+    TableArray() = default;
+    TableArray(const TableArray& rhs) : shape(rhs.shape), count(rhs.count)
+    {
+        for (const ValueStorage* column : rhs.columns)
+            columns.push_back(column ? column->clone() : nullptr);
+        for (const ValueStorage* storage : rhs.storageTypes)
+            storageTypes.push_back(storage->createEmpty());
+        rows.reserve(rhs.rows.size());
+        for (const Table& row : rhs.rows)
+            rows.push_back(cloneTable(row));
+    }
+    TableArray(TableArray&& rhs)
+        : shape(std::move(rhs.shape)), columns(std::move(rhs.columns)), storageTypes(std::move(rhs.storageTypes)),
+          rows(std::move(rhs.rows)), count(rhs.count)
+    {
+        rhs.columns.clear();
+        rhs.storageTypes.clear();
+        rhs.count = 0;
+    }
+    TableArray& operator=(TableArray rhs)
+    {
+        std::swap(shape, rhs.shape);
+        std::swap(columns, rhs.columns);
+        std::swap(storageTypes, rhs.storageTypes);
+        std::swap(rows, rhs.rows);
+        std::swap(count, rhs.count);
+        return *this;
+    }
+    ~TableArray()
+    {
+        for (ValueStorage* column : columns)
+            delete column;
+        for (ValueStorage* storage : storageTypes)
+            delete storage;
+    }
+
+    // Takes the elements over, columnar if they all have the same shape
+    static TableArray fromTables(std::vector<Table> tables);
+
+    size_t size() const { return count; }
+    bool columnar() const { return shape != nullptr; }
+
+    // Values of `name` of all the elements, empty if the array isn't columnar or has no such key of type T
+    template<typename T>
+    std::span<const T> column(const std::string_view& name) const
+    {
+        static_assert(!std::is_same_v<T, bool>, "bools are packed, see bitColumn");
+        const TypedStorage<T>* col = findColumn<T>(name);
+        if (!col)
+            return {};
+        return col->storage;
+    }
+
+    // Same for bools, nullptr if there's no such column
+    const BitVector* bitColumn(const std::string_view& name) const
+    {
+        const TypedStorage<bool>* col = findColumn<bool>(name);
+        return col ? &col->storage : nullptr;
+    }
+
+    template<typename T>
+    T getOr(size_t idx, const std::string_view& name, T def) const
+    {
+        if (!shape)
+            return rows[idx].getOr<T>(name, def);
+        const TypedStorage<T>* col = findColumn<T>(name);
+        return col ? T(col->storage[idx]) : def;
+    }
+
+    template<typename T>
+    const TypedStorage<T>* findColumn(const std::string_view& name) const
+    {
+        if (!shape)
+            return nullptr;
+        auto itf = shape->nameMap.find(name);
+        if (itf == shape->nameMap.end())
+            return nullptr;
+        const ValueStorage* col = columns[itf->second];
+        if (!col || col->type() != typeid(T))
+            return nullptr;
+        return (const TypedStorage<T>*)col;
+    }
+
+    // The idx-th element as a standalone table (a copy)
+    Table row(size_t idx) const;
+
+    size_t memoryBytes() const;
+};
+
+inline TableArray TableArray::fromTables(std::vector<Table> tables)
+{
+    TableArray res;
+    res.count = tables.size();
+    bool sameShape = !tables.empty();
+    for (size_t i = 1; i < tables.size() && sameShape; ++i)
+        sameShape = tables[i].shape == tables[0].shape || *tables[i].shape == *tables[0].shape;
+    if (!sameShape)
+    {
+        res.rows = std::move(tables);
+        return res;
+    }
+
+    const Table& first = tables[0];
+    res.shape = first.shape;
+    for (const ValueStorage* storage : first.storages)
+        res.storageTypes.push_back(storage->createEmpty());
+    res.columns.resize(res.shape->records.size(), nullptr);
+    for (size_t i = 0; i < res.columns.size(); ++i)
+    {
+        const Table::TableRecord& rec = res.shape->records[i];
+        if (rec.storageId >= first.storages.size())
+            continue;
+        ValueStorage* column = first.storages[rec.storageId]->createEmpty();
+        for (Table& tbl : tables)
+            column->pushMoved(*tbl.storages[rec.storageId], rec.idx);
+        res.columns[i] = column;
+    }
+    return res;
+}
+
+inline Table TableArray::row(size_t idx) const
+{
+    if (!shape)
+        return cloneTable(rows[idx]);
+    Table res;
+    res.shape = shape;
+    for (const ValueStorage* storage : storageTypes)
+        res.storages.push_back(storage->createEmpty());
+    // Values go into the storages in the order the shape has them there
+    for (size_t storageId = 0; storageId < res.storages.size(); ++storageId)
+        for (size_t nameId : shape->nameIds[storageId])
+            res.storages[storageId]->pushCopy(*columns[nameId], idx);
+    return res;
+}
+
+inline size_t TableArray::memoryBytes() const
+{
+    size_t res = (columns.capacity() + storageTypes.capacity()) * sizeof(ValueStorage*);
+    if (shape)
+        res += shape->memoryBytes() / (size_t)shape.use_count();
+    for (const ValueStorage* column : columns)
+        if (column)
+            res += column->memoryUsage();
+    for (const ValueStorage* storage : storageTypes)
+        res += storage->memoryUsage();
+    res += heapBytes(rows);
+    return res;
+}
+
+inline size_t heapBytes(const TableArray& arr)
+{
+    return arr.memoryBytes();
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "edat.h"
+
+namespace edat
+{
+
+// Scratch tables for per-request work. Released tables are cleared (keeping all their memory, see Table::clear)
+// and handed out again, so once the pool has warmed up a request cycle doesn't allocate for the table itself.
+// Safe to share between threads, a single table is only ever handed to one user at a time.
+//
+//   TablePool pool(8);
+//   {
+//       TablePool::Lease tbl = pool.acquire();
+//       tbl->set("x", 1.f);
+//   } // back in the pool
+struct TablePool
+{
+    // Returns the table to the pool when destroyed
+    struct Lease
+    {
+        TablePool* pool = nullptr;
+        std::unique_ptr<Table> table;
+
+        Lease() = default;
+        Lease(TablePool* pool, std::unique_ptr<Table> table) : pool(pool), table(std::move(table)) {}
+        Lease(Lease&& rhs) = default;
+        Lease& operator=(Lease&& rhs)
+        {
+            if (this != &rhs)
+            {
+                release();
+                pool = rhs.pool;
+                table = std::move(rhs.table);
+            }
+            return *this;
+        }
+        ~Lease() { release(); }
+
+        void release()
+        {
+            if (pool && table)
+                pool->release(std::move(table));
+            table.reset();
+        }
+
+        Table& operator*() const { return *table; }
+        Table* operator->() const { return table.get(); }
+    };
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Table>> freeTables;
+
+    // `prewarm` tables are created up front with room for `keysPerTable` keys each
+    explicit TablePool(size_t prewarm = 0, size_t keysPerTable = 0)
+    {
+        freeTables.reserve(prewarm);
+        for (size_t i = 0; i < prewarm; ++i)
+        {
+            freeTables.push_back(std::make_unique<Table>());
+            freeTables.back()->reserve(keysPerTable);
+        }
+    }
+
+    TablePool(const TablePool&) = delete;
+    TablePool& operator=(const TablePool&) = delete;
+
+    // A cleared table, a new one if the pool ran dry
+    Lease acquire()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!freeTables.empty())
+            {
+                std::unique_ptr<Table> table = std::move(freeTables.back());
+                freeTables.pop_back();
+                return Lease(this, std::move(table));
+            }
+        }
+        return Lease(this, std::make_unique<Table>());
+    }
+
+    void release(std::unique_ptr<Table> table)
+    {
+        // Clearing is done outside of the lock, it may have to destroy nested tables and strings
+        table->clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        freeTables.push_back(std::move(table));
+    }
+
+    size_t available()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return freeTables.size();
+    }
+};
+
+}
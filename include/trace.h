@@ -0,0 +1,93 @@
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Tracing spans around parsing, cloning and reloads, exported in the Chrome trace event format
+// (open in chrome://tracing or ui.perfetto.dev).
+// Only compiled in with -DEDAT_TRACING=ON, otherwise the macros expand to nothing and the functions do nothing.
+// Even when compiled in, spans are only recorded between trace::start() and trace::stop().
+//
+//   edat::trace::start();
+//   edat::Table tbl = edat::parseFile("big.edat", psuite);
+//   edat::trace::stop();
+//   edat::trace::writeChromeTrace("load.json");
+
+namespace edat::trace
+{
+
+#ifdef EDAT_TRACING
+
+void start();
+void stop();
+bool enabled();
+// Drops everything recorded so far
+void clear();
+// Writes all the spans recorded so far, returns false (and reports it) if the file can't be written
+bool writeChromeTrace(const std::filesystem::path& path);
+
+uint64_t nowNs();
+void record(const char* name, std::string detail, uint64_t startNs, uint64_t endNs);
+
+// `name` must be a string literal (or otherwise outlive the trace), `detail` is copied
+struct Scope
+{
+    const char* name = nullptr;
+    std::string detail;
+    uint64_t startNs = 0;
+
+    Scope(const char* name, std::string_view detail = {})
+    {
+        if (!enabled())
+            return;
+        this->name = name;
+        this->detail = detail;
+        startNs = nowNs();
+    }
+
+    // The detail is only built when tracing is active, see EDAT_TRACE_SCOPE_DETAIL
+    template<typename DetailFn>
+        requires std::is_invocable_v<DetailFn&>
+    Scope(const char* name, DetailFn&& detailFn)
+    {
+        if (!enabled())
+            return;
+        this->name = name;
+        this->detail = detailFn();
+        startNs = nowNs();
+    }
+
+    ~Scope()
+    {
+        if (name)
+            record(name, std::move(detail), startNs, nowNs());
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+};
+
+#define EDAT_TRACE_CONCAT_IMPL(a, b) a##b
+#define EDAT_TRACE_CONCAT(a, b) EDAT_TRACE_CONCAT_IMPL(a, b)
+// Span from here till the end of the enclosing scope
+#define EDAT_TRACE_SCOPE(name) edat::trace::Scope EDAT_TRACE_CONCAT(edatTraceScope, __LINE__)(name)
+// `detail` is evaluated only while tracing is active, so it can build a string without slowing down untraced runs
+#define EDAT_TRACE_SCOPE_DETAIL(name, detail) \
+    edat::trace::Scope EDAT_TRACE_CONCAT(edatTraceScope, __LINE__)(name, [&]() { return std::string(detail); })
+
+#else
+
+inline void start() {}
+inline void stop() {}
+inline bool enabled() { return false; }
+inline void clear() {}
+inline bool writeChromeTrace(const std::filesystem::path&) { return false; }
+
+#define EDAT_TRACE_SCOPE(name)
+#define EDAT_TRACE_SCOPE_DETAIL(name, detail)
+
+#endif
+
+}
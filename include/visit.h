@@ -0,0 +1,111 @@
+#pragma once
+
+#include <type_traits>
+#include "edat.h"
+#include "fixed_array.h"
+#include "table_array.h"
+
+namespace edat
+{
+
+// Usual helper to build a visitor out of several lambdas
+template<typename... Ts>
+struct overloaded : Ts...
+{
+    using Ts::operator()...;
+};
+template<typename... Ts>
+overloaded(Ts...) -> overloaded<Ts...>;
+
+template<typename... Ts>
+struct TypeList {};
+
+using DefaultVisitTypes = TypeList<int, float, bool, std::string,
+                                   std::vector<int>, std::vector<float>, std::vector<std::string>, BitVector,
+                                   FixedArray<int>, FixedArray<float>, FixedArray<bool>, FixedArray<std::string>,
+                                   Table, TableArray>;
+
+template<typename List, typename... Ts>
+struct AppendTypes;
+template<typename... Ls, typename... Ts>
+struct AppendTypes<TypeList<Ls...>, Ts...>
+{
+    using type = TypeList<Ls..., Ts...>;
+};
+
+// The default types plus your own, e.g. enums: visit<VisitTypesWith<BlendMode>>(tbl, visitor)
+template<typename... Ts>
+using VisitTypesWith = typename AppendTypes<DefaultVisitTypes, Ts...>::type;
+
+// Handed to the visitor for values whose type isn't in the visited type list (or which the visitor
+// has no overload for exactly that type), so nothing is skipped silently
+struct UnknownValue
+{
+    const std::type_info& type;
+    const ValueStorage& storage;
+    size_t idx;
+};
+
+template<typename Visitor>
+using VisitDispatch = void(*)(const ValueStorage& storage, size_t idx, const std::string& name, Visitor& visitor);
+
+template<typename Visitor>
+void visitUnknown(const ValueStorage& storage, size_t idx, const std::string& name, Visitor& visitor)
+{
+    if constexpr (std::is_invocable_v<Visitor&, const std::string&, const UnknownValue&>)
+        visitor(name, UnknownValue{storage.type(), storage, idx});
+}
+
+// Converts to T (or a reference to it) and nothing else. Checking the visitor with a plain T would also pick
+// overloads T converts to: ints reaching a float overload, bools an int one.
+template<typename T>
+struct ExactArg
+{
+    template<typename U>
+        requires std::is_same_v<std::remove_cv_t<U>, T>
+    operator U&() const;
+};
+
+// The visitor has an overload taking exactly T (by value or reference, or a generic one)
+template<typename Visitor, typename T>
+constexpr bool visitsExactly = std::is_invocable_v<Visitor&, const std::string&, ExactArg<T>>;
+
+template<typename T, typename Visitor>
+void visitTyped(const ValueStorage& storage, size_t idx, const std::string& name, Visitor& visitor)
+{
+    if constexpr (visitsExactly<Visitor, T>)
+        visitor(name, ((const TypedStorage<T>&)storage).storage[idx]);
+    else
+        visitUnknown(storage, idx, name, visitor);
+}
+
+template<typename Visitor, typename T, typename... Ts>
+VisitDispatch<Visitor> findVisitDispatch(const std::type_info& type, TypeList<T, Ts...>)
+{
+    if (type == typeid(T))
+        return &visitTyped<T, Visitor>;
+    if constexpr (sizeof...(Ts) > 0)
+        return findVisitDispatch<Visitor>(type, TypeList<Ts...>{});
+    else
+        return &visitUnknown<Visitor>;
+}
+
+// Calls visitor(name, value) once for every entry of the table, in insertion order, with the value
+// in its concrete type: only an overload for exactly that type gets it, no conversions. Types are resolved once per storage into a jump table, so the whole walk is
+// a single linear pass over the records with one indirect call per entry.
+// Types to dispatch on come from `Types` (see VisitTypesWith), anything else is passed as UnknownValue.
+template<typename Types = DefaultVisitTypes, typename Visitor>
+void visit(const Table& tbl, Visitor&& visitor)
+{
+    std::vector<VisitDispatch<std::remove_reference_t<Visitor>>> jumpTable;
+    jumpTable.reserve(tbl.storages.size());
+    for (const ValueStorage* storage : tbl.storages)
+        jumpTable.push_back(findVisitDispatch<std::remove_reference_t<Visitor>>(storage->type(), Types{}));
+
+    for (const Table::TableRecord& record : tbl.shape->records)
+        if (record.storageId < jumpTable.size())
+            jumpTable[record.storageId](*tbl.storages[record.storageId], record.idx, tbl.shape->names[record.nameId], visitor);
+}
+
+}
+
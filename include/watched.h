@@ -0,0 +1,99 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "parsers.h"
+#include "snapshot.h"
+
+namespace edat
+{
+
+// Keeps a set of .edat files parsed and reparses them in a background thread when they change on disk.
+// Change detection uses inotify on Linux and falls back to polling modification time and size elsewhere
+// (or if inotify isn't available, or for files in directories it can't watch).
+// Files that fail to parse are reported and don't replace the version that's published already.
+//
+// Every reload is published RCU-style: the new snapshot is swapped in atomically, readers that grabbed
+// the old one keep using it until they drop it. The read path takes no locks: a reader announces the
+// version it's about to reference in a hazard slot (one per cache line, picked by thread) for the duration
+// of a pointer load and a refcount increment. Retired versions are freed as soon as no slot holds them, so
+// at most hazardSlots of them are ever kept alive, whatever the reader load. Hot loops should keep the
+// Snapshot they got and only call get() again once generation() changes.
+struct Watched
+{
+    Watched(std::vector<std::filesystem::path> paths, const ParserSuite& psuite,
+            std::chrono::milliseconds pollInterval = std::chrono::milliseconds(500));
+    ~Watched();
+
+    Watched(const Watched&) = delete;
+    Watched& operator=(const Watched&) = delete;
+
+    size_t size() const { return files.size(); }
+    const std::filesystem::path& path(size_t fileIdx) const { return files[fileIdx]->path; }
+
+    // Latest published version of a file, safe to call from any thread
+    Snapshot get(size_t fileIdx) const;
+    // Incremented on every successful reload, cheap way for readers to check if their snapshot is stale
+    uint64_t generation(size_t fileIdx) const { return files[fileIdx]->generation.load(std::memory_order_acquire); }
+
+    // Reparses the file right away and publishes the result. Returns false if the file couldn't be read
+    // or has errors, the previous version stays published then.
+    bool reload(size_t fileIdx);
+
+    struct Published
+    {
+        Snapshot snapshot;
+    };
+
+    struct WatchedFile
+    {
+        std::filesystem::path path;
+        std::atomic<Published*> current = nullptr;
+        std::atomic<uint64_t> generation = 0;
+
+        // Stamp of the version being loaded, taken before reading it so writes during a parse aren't missed.
+        // Used by the polling fallback, guarded by publishMutex.
+        std::filesystem::file_time_type lastWriteTime;
+        uintmax_t lastSize = 0;
+        int watchDescriptor = -1; // inotify watch of the file's directory, polled if there's none
+    };
+
+    // Readers that find all the slots taken fall back to reading under publishMutex
+    static constexpr size_t hazardSlots = 64;
+    struct alignas(64) HazardSlot
+    {
+        std::atomic<Published*> published = nullptr;
+    };
+
+    const ParserSuite& psuite;
+    std::chrono::milliseconds pollInterval;
+    std::vector<std::unique_ptr<WatchedFile>> files;
+
+    // Version each in-flight reader is about to take a reference to, retired versions still in a slot aren't deleted
+    mutable std::array<HazardSlot, hazardSlots> hazards;
+
+    mutable std::mutex publishMutex; // serializes the watcher thread and manual reload() calls
+    std::vector<Published*> retired;
+
+    std::mutex stopMutex;
+    std::condition_variable stopCondition;
+    bool stopRequested = false;
+    int stopPipe[2] = {-1, -1};
+    int inotifyFd = -1;
+    std::thread watcher;
+
+    void publish(WatchedFile& file, Table&& tbl);
+    void reclaimRetired();
+    // Reloads the files whose stamp changed, only the ones without an inotify watch if `unwatchedOnly`
+    bool pollForChanges(bool unwatchedOnly = false);
+    void watchLoop();
+};
+
+}
+
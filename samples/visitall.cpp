@@ -1,26 +1,50 @@
 #include <edat.h>
 #include <parsers.h>
+#include <visit.h>
 
 namespace fs = std::filesystem;
 
-void printContents(const edat::Table& tbl)
+enum class BlendMode : uint8_t { Opaque, Additive, Multiply };
+
+using PrintTypes = edat::VisitTypesWith<BlendMode>;
+
+void printContents(const edat::Table& tbl, const edat::ParserSuite& psuite, int depth = 0)
 {
-    printf("All integers:\n");
-    tbl.getAll<int>([&](const std::string& name, int val) { printf("\t%s: %d\n", name.c_str(), val); } );
-    printf("All floats:\n");
-    tbl.getAll<float>([&](const std::string& name, float val) { printf("\t%s: %f\n", name.c_str(), val); } );
-    printf("All float[]:\n");
-    tbl.getAll<std::vector<float>>([&](const std::string& name, const std::vector<float>& val)
-    {
-        printf("\t%s: [", name.c_str());
-        for (float f : val)
-            printf("%f, ", f);
-        printf("]\n");
+    const std::string indent(depth + 1, '\t');
+    edat::visit<PrintTypes>(tbl, edat::overloaded{
+        [&](const std::string& name, int val) { printf("%s%s: %d\n", indent.c_str(), name.c_str(), val); },
+        [&](const std::string& name, float val) { printf("%s%s: %f\n", indent.c_str(), name.c_str(), val); },
+        [&](const std::string& name, bool val) { printf("%s%s: %s\n", indent.c_str(), name.c_str(), val ? "true" : "false"); },
+        [&](const std::string& name, const std::string& val) { printf("%s%s: '%s'\n", indent.c_str(), name.c_str(), val.c_str()); },
+        [&](const std::string& name, const std::vector<float>& val)
+        {
+            printf("%s%s: [", indent.c_str(), name.c_str());
+            for (float f : val)
+                printf("%f, ", f);
+            printf("]\n");
+        },
+        [&](const std::string& name, const edat::BitVector& val)
+        {
+            printf("%s%s: [", indent.c_str(), name.c_str());
+            for (size_t i = 0; i < val.size(); ++i)
+                printf("%s, ", val[i] ? "true" : "false");
+            printf("] (%zu set)\n", val.popcount());
+        },
+        [&](const std::string& name, BlendMode val)
+        {
+            const std::string_view valName = psuite.findEnum<BlendMode>("blend")->name(val);
+            printf("%s%s: %.*s\n", indent.c_str(), name.c_str(), (int)valName.size(), valName.data());
+        },
+        [&](const std::string& name, const edat::Table& val)
+        {
+            printf("%s%s:\n", indent.c_str(), name.c_str());
+            printContents(val, psuite, depth + 1);
+        },
+        [&](const std::string& name, const edat::UnknownValue& val)
+        {
+            printf("%s%s: <%s>\n", indent.c_str(), name.c_str(), val.type.name());
+        }
     });
-    printf("All strings:\n");
-    tbl.getAll<std::string>([&](const std::string& name, const std::string& val) { printf("\t%s: '%s'\n", name.c_str(), val.c_str()); } );
-    printf("All tables:\n");
-    tbl.getAll<edat::Table>([&](const std::string& name, const edat::Table& tbl) { printContents(tbl); });
 }
 
 int main(int argc, const char** argv)
@@ -54,6 +78,8 @@ int main(int argc, const char** argv)
     {
         return std::string(str);
     });
+    psuite.addLambdaParser<bool>("bool", edat::parseBool);
+    psuite.addEnum<BlendMode>("blend", {{"opaque", BlendMode::Opaque}, {"additive", BlendMode::Additive}, {"multiply", BlendMode::Multiply}});
 
     printf("\n\nParsing in-memory string\n\n");
     std::string fileContents =  " something : float = \"-2\"\n"
@@ -63,15 +89,22 @@ int main(int argc, const char** argv)
                                 "ScientificNumber  :   float = \"1e5\"";
 
     edat::Table res = edat::parseString(fileContents, psuite);
-    printContents(res);
+    printContents(res, psuite);
 
     printf("\n\nReading simple.edat from file\n");
 
     fs::path simple = "simple.edat";
     fs::path fullPath = fs::current_path() / simple;
 
-    edat::Table fres = edat::parseFile(fullPath, psuite);
-    printContents(fres);
+    edat::ParseStats stats;
+    edat::Table fres = edat::parseFile(fullPath, psuite, &stats);
+    printContents(fres, psuite);
+    printf("\n");
+    edat::printParseStats(stats);
+
+    // Bools (bit-packed, also as arrays) and enum values
+    printf("\n\nReading types.edat from file\n");
+    printContents(edat::parseFile(fs::current_path() / "types.edat", psuite), psuite);
 
     return 0;
 }
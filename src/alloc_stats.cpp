@@ -0,0 +1,80 @@
+#include "alloc_stats.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+// Only built with -DEDAT_ALLOC_STATS=ON, replaces the global allocation functions with counting ones
+
+namespace edat
+{
+
+// Plain zero-initialized thread_local, so there's no lazy init to trip over from inside operator new
+static thread_local ThreadAllocCounters counters = {};
+
+ThreadAllocCounters& threadAllocCounters()
+{
+    return counters;
+}
+
+static void* countedAlloc(size_t size, size_t alignment)
+{
+    if (size == 0)
+        size = 1;
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t))
+        ptr = malloc(size);
+    else if (posix_memalign(&ptr, alignment, size) != 0)
+        ptr = nullptr;
+    if (!ptr)
+        return nullptr;
+
+    counters.count++;
+    counters.bytes += size;
+    counters.liveBytes += int64_t(malloc_usable_size(ptr));
+    if (counters.liveBytes > counters.peakLiveBytes)
+        counters.peakLiveBytes = counters.liveBytes;
+    return ptr;
+}
+
+static void countedFree(void* ptr)
+{
+    if (!ptr)
+        return;
+    counters.frees++;
+    counters.liveBytes -= int64_t(malloc_usable_size(ptr));
+    free(ptr);
+}
+
+static void* countedAllocOrThrow(size_t size, size_t alignment)
+{
+    void* ptr = countedAlloc(size, alignment);
+    if (!ptr)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+}
+
+void* operator new(size_t size) { return edat::countedAllocOrThrow(size, 0); }
+void* operator new[](size_t size) { return edat::countedAllocOrThrow(size, 0); }
+void* operator new(size_t size, std::align_val_t al) { return edat::countedAllocOrThrow(size, size_t(al)); }
+void* operator new[](size_t size, std::align_val_t al) { return edat::countedAllocOrThrow(size, size_t(al)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return edat::countedAlloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return edat::countedAlloc(size, 0); }
+void* operator new(size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return edat::countedAlloc(size, size_t(al)); }
+void* operator new[](size_t size, std::align_val_t al, const std::nothrow_t&) noexcept { return edat::countedAlloc(size, size_t(al)); }
+
+void operator delete(void* ptr) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { edat::countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { edat::countedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { edat::countedFree(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { edat::countedFree(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { edat::countedFree(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { edat::countedFree(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { edat::countedFree(ptr); }
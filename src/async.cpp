@@ -0,0 +1,277 @@
+#include "async.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifdef EDAT_HAVE_IO_URING
+#include <liburing.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace edat
+{
+
+// Fallback for when io_uring isn't available, blocking reads on a couple of dedicated threads
+struct IoThreadPool
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> jobs;
+    bool stopping = false;
+    std::vector<std::thread> threads;
+
+    explicit IoThreadPool(size_t threadCount)
+    {
+        for (size_t i = 0; i < threadCount; ++i)
+            threads.emplace_back([this]() { run(); });
+    }
+
+    ~IoThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    void post(std::function<void()> job)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        condition.notify_one();
+    }
+
+    void run()
+    {
+        while (true)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+                return;
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+        }
+    }
+};
+
+static IoThreadPool& ioThreadPool()
+{
+    static IoThreadPool pool(2);
+    return pool;
+}
+
+#ifdef EDAT_HAVE_IO_URING
+// Single ring shared by all reads, submissions are serialized and a dedicated thread reaps completions.
+// A read is three chained steps on the ring (open, statx for the size, read), so nothing blocks the caller.
+struct UringReader
+{
+    struct Request
+    {
+        enum class Step { Open, Stat, Read };
+
+        std::string path;
+        Step step = Step::Open;
+        int fd = -1;
+        struct statx stx = {};
+        size_t offset = 0;
+        std::string contents;
+        std::function<void(std::optional<std::string>)> done;
+    };
+
+    io_uring ring;
+    bool initialized = false;
+    std::mutex submitMutex;
+    std::thread reaper;
+    std::atomic<size_t> inFlight = 0; // requests between read() and finish(), the reaper drains them before stopping
+
+    UringReader()
+    {
+        initialized = io_uring_queue_init(64, &ring, 0) == 0;
+        if (initialized)
+            reaper = std::thread([this]() { reap(); });
+    }
+
+    ~UringReader()
+    {
+        if (!initialized)
+            return;
+        // A request without data tells the reaper to stop. If the submission queue is full, flushing it
+        // to the kernel makes room, retry until the stop request is queued.
+        while (true)
+        {
+            std::lock_guard<std::mutex> lock(submitMutex);
+            if (io_uring_sqe* sqe = io_uring_get_sqe(&ring))
+            {
+                io_uring_prep_nop(sqe);
+                io_uring_sqe_set_data(sqe, nullptr);
+                io_uring_submit(&ring);
+                break;
+            }
+            io_uring_submit(&ring);
+        }
+        reaper.join();
+        io_uring_queue_exit(&ring);
+    }
+
+    // Queues the request's current step
+    bool submit(Request* req)
+    {
+        std::lock_guard<std::mutex> lock(submitMutex);
+        io_uring_sqe* sqe = io_uring_get_sqe(&ring);
+        if (!sqe)
+            return false;
+        switch (req->step)
+        {
+        case Request::Step::Open:
+            io_uring_prep_openat(sqe, AT_FDCWD, req->path.c_str(), O_RDONLY | O_CLOEXEC, 0);
+            break;
+        case Request::Step::Stat:
+            io_uring_prep_statx(sqe, req->fd, "", AT_EMPTY_PATH, STATX_SIZE, &req->stx);
+            break;
+        case Request::Step::Read:
+            io_uring_prep_read(sqe, req->fd, req->contents.data() + req->offset,
+                               unsigned(req->contents.size() - req->offset), req->offset);
+            break;
+        }
+        io_uring_sqe_set_data(sqe, req);
+        return io_uring_submit(&ring) >= 0;
+    }
+
+    void finish(Request* req, bool ok)
+    {
+        if (req->fd >= 0)
+            close(req->fd);
+        req->contents.resize(req->offset);
+        if (ok)
+            req->done(std::move(req->contents));
+        else
+            req->done(std::nullopt);
+        delete req;
+        inFlight.fetch_sub(1);
+    }
+
+    // Moves the request on after its current step completed with `res`
+    void advance(Request* req, int res)
+    {
+        if (res < 0)
+        {
+            finish(req, false);
+            return;
+        }
+        switch (req->step)
+        {
+        case Request::Step::Open:
+            req->fd = res;
+            req->step = Request::Step::Stat;
+            break;
+        case Request::Step::Stat:
+            if (req->stx.stx_size == 0)
+            {
+                finish(req, true);
+                return;
+            }
+            req->contents.resize(size_t(req->stx.stx_size));
+            req->step = Request::Step::Read;
+            break;
+        case Request::Step::Read:
+            // Reads can come back short, continue where it stopped.
+            // Nothing read means the file got shorter since statx, what's there is the whole file.
+            req->offset += size_t(res);
+            if (res == 0 || req->offset == req->contents.size())
+            {
+                finish(req, true);
+                return;
+            }
+            break;
+        }
+        if (!submit(req))
+            finish(req, false);
+    }
+
+    void reap()
+    {
+        bool stopping = false;
+        while (!stopping || inFlight.load() != 0)
+        {
+            io_uring_cqe* cqe = nullptr;
+            if (io_uring_wait_cqe(&ring, &cqe) < 0)
+                continue;
+            Request* req = (Request*)io_uring_cqe_get_data(cqe);
+            const int res = cqe->res;
+            io_uring_cqe_seen(&ring, cqe);
+            if (!req)
+                stopping = true;
+            else
+                advance(req, res);
+        }
+    }
+
+    bool read(const std::filesystem::path& path, std::function<void(std::optional<std::string>)>& done)
+    {
+        Request* req = new Request();
+        req->path = path.string();
+        req->done = std::move(done);
+        inFlight.fetch_add(1);
+        if (!submit(req))
+        {
+            // Ring is full, give the callback back to the caller so it can use the thread pool
+            done = std::move(req->done);
+            delete req;
+            inFlight.fetch_sub(1);
+            return false;
+        }
+        return true;
+    }
+};
+
+static UringReader& uringReader()
+{
+    static UringReader reader;
+    return reader;
+}
+#endif
+
+void readFileInBackground(std::filesystem::path path, std::function<void(std::optional<std::string>)> done)
+{
+#ifdef EDAT_HAVE_IO_URING
+    UringReader& reader = uringReader();
+    if (reader.initialized && done && reader.read(path, done))
+        return;
+#endif
+    ioThreadPool().post([path = std::move(path), done = std::move(done)]()
+    {
+        std::string contents;
+        if (readFile(path, contents))
+            done(std::move(contents));
+        else
+            done(std::nullopt);
+    });
+}
+
+Task<edat::Table> parseFileAsync(std::filesystem::path path, const ParserSuite& psuite, Executor& executor,
+                                 size_t yieldEvery)
+{
+    std::optional<std::string> contents = co_await readFileAsync(std::move(path), executor);
+    if (!contents)
+        co_return edat::Table{};
+
+    IncrementalParser parser(*contents, psuite);
+    while (parser.step(yieldEvery))
+        co_await schedule(executor);
+    co_return std::move(parser.result);
+}
+
+}
@@ -1,4 +1,9 @@
 #include "parsers.h"
+#include "parallel.h"
+#include "table_array.h"
+#include "trace.h"
+
+#include <charconv>
 
 namespace edat
 {
@@ -36,14 +41,14 @@ static bool skipLineBreak(std::string_view& input)
 
 static bool isNameChar(const char ch)
 {
-    return std::isalnum(ch) || ch == '_';
+    return std::isalnum((unsigned char)ch) || ch == '_';
 }
 
 template<typename Callable>
 static std::string_view parseWhile(std::string_view& input, Callable c)
 {
     size_t len = 0;
-    while (c(input[len]))
+    while (len < input.size() && c(input[len]))
         len++;
     std::string_view res(input.data(), len);
     input.remove_prefix(len);
@@ -75,18 +80,41 @@ static bool skipArrayEnd(std::string_view& input)
     return skipChar(input, ']');
 }
 
-static int parseArraySpecifier(std::string_view& input)
+// `[N][M]...` after a type name
+struct ArraySpec
+{
+    size_t rank = 0; // 0 if not an array
+    std::array<size_t, fixedArrayMaxRank> extents = {}; // 0 for a dynamic dimension (`[]`)
+    bool valid = true;
+};
+
+static ArraySpec parseArraySpecifier(std::string_view& input)
 {
-    if (!skipArrayStart(input))
-        return -1;
-    std::string_view sizeSpec = parseWhile(input, [](char ch) { return std::isdigit(ch); });
-    if (sizeSpec.empty())
+    ArraySpec res;
+    while (skipArrayStart(input))
     {
-        skipArrayEnd(input);
-        return 0; // dynamic array
+        std::string_view sizeSpec = parseWhile(input, [](char ch) { return std::isdigit((unsigned char)ch); });
+        size_t size = 0;
+        if (std::from_chars(sizeSpec.data(), sizeSpec.data() + sizeSpec.size(), size).ec == std::errc::result_out_of_range)
+            res.valid = false;
+        if (!skipArrayEnd(input) || res.rank == fixedArrayMaxRank)
+            res.valid = false;
+        else
+            res.extents[res.rank] = size;
+        res.rank++;
     }
-    skipArrayEnd(input);
-    return std::stoi(std::string(sizeSpec));
+    // Only the outermost dimension can be left for the values to decide, and the whole size has to fit
+    size_t total = 1;
+    for (size_t dim = 0; dim < res.rank && dim < fixedArrayMaxRank; ++dim)
+    {
+        if (res.extents[dim] == 0 && dim > 0)
+            res.valid = false;
+        if (res.extents[dim] != 0 && total > SIZE_MAX / res.extents[dim])
+            res.valid = false;
+        else if (res.extents[dim] != 0)
+            total *= res.extents[dim];
+    }
+    return res;
 }
 
 static std::string_view parseUntilEndOfQuotation(std::string_view& input)
@@ -140,7 +168,8 @@ static void exit_color()
 
 static void reportErrorLocation(const char* lineStart, const std::string_view& currentView)
 {
-    std::string_view line(lineStart);
+    // The view always runs till the end of the input, only look as far as the end of the line from there
+    std::string_view line(lineStart, currentView.data() + currentView.size() - lineStart);
     line = parseUntilEndOfLine(line);
     printf("  %.*s\n", int(line.size()), line.data());
     printf("  ");
@@ -160,7 +189,7 @@ static bool skipEndOfTable(std::string_view& input)
     return skipChar(input, '}');
 }
 
-static std::tuple<std::string_view, std::string_view, int> parseKey(std::string_view& view)
+static std::tuple<std::string_view, std::string_view, ArraySpec> parseKey(std::string_view& view)
 {
     skipWhitespace(view);
     std::string_view name = parseName(view);
@@ -169,11 +198,11 @@ static std::tuple<std::string_view, std::string_view, int> parseKey(std::string_
     {
         skipWhitespace(view);
         std::string_view typeName = parseName(view);
-        int arraySize = parseArraySpecifier(view);
+        ArraySpec arraySpec = parseArraySpecifier(view);
         skipWhitespace(view);
-        return std::make_tuple(name, typeName, arraySize);
+        return std::make_tuple(name, typeName, arraySpec);
     }
-    return std::make_tuple(name, std::string_view{}, -1);
+    return std::make_tuple(name, std::string_view{}, ArraySpec{});
 }
 
 static std::string_view parseValue(std::string_view& view)
@@ -186,15 +215,12 @@ static std::string_view parseValue(std::string_view& view)
     return val;
 }
 
-static TypeParser* getTypeParser(std::string_view typeName, const ParserSuite& psuite)
+static const TypeParser* getTypeParser(std::string_view typeName, const ParserSuite& psuite)
 {
-    auto itf = psuite.typeParsers.find(std::string(typeName));
-    if (itf == psuite.typeParsers.end())
-    {
+    const TypeParser* parser = psuite.findParser(typeName);
+    if (!parser)
         printf("Warning: don't have parser for type '%.*s'! Skipping.\n", (int)typeName.size(), typeName.data());
-        return nullptr;
-    }
-    return itf->second;
+    return parser;
 }
 
 static void reportError(const char* message, const char* lineStart, const std::string_view& view)
@@ -206,6 +232,29 @@ static void reportError(const char* message, const char* lineStart, const std::s
     reportErrorLocation(lineStart, view);
 }
 
+// Parsers with a closed set of values reject the others, the entry fails at the first rejected value.
+// `lineStart` is where the entry starts, array values can be on any of the lines after it.
+static bool checkValues(const TypeParser& parser, std::string_view typeName, std::span<const std::string_view> values,
+                        const char* lineStart, const std::string_view& view)
+{
+    if (!parser.checksValues)
+        return true;
+    for (const std::string_view& val : values)
+    {
+        if (parser.acceptsValue(val))
+            continue;
+        const char* valueLineStart = val.data();
+        while (valueLineStart > lineStart && valueLineStart[-1] != '\n')
+            valueLineStart--;
+        char message[256];
+        snprintf(message, sizeof(message), "unknown value '%.*s' of type '%.*s'", (int)std::min<size_t>(val.size(), 64),
+                 val.data(), (int)typeName.size(), typeName.data());
+        reportError(message, valueLineStart, std::string_view(val.data(), view.data() + view.size() - val.data()));
+        return false;
+    }
+    return true;
+}
+
 static bool skipCopyOperator(std::string_view& view)
 {
     std::string_view tview = view;
@@ -227,118 +276,536 @@ static std::string_view parseCopyExpression(std::string_view& view)
     return parseName(view);
 }
 
-// TODO: better error reporting (custom streams, with cerr as default one)
-// TODO: comments parsing
-// TODO: support unquoted values
-// TODO: check for formatting better
-// TODO: proper return if encountering an error
-// TODO: check for memory leaks
-edat::Table parseView(std::string_view& view, const ParserSuite& psuite, const edat::Table* cloneFrom = nullptr)
+enum class EntryResult
 {
-    edat::Table res;
-    if (cloneFrom)
-        res = cloneTable(*cloneFrom);
-    const char* lineStart = view.data();
-    while (view.size() > 0)
+    Continue,
+    EndOfTable,
+    Error
+};
+
+static void countValues(ParseStats& stats, std::string_view typeName, uint64_t count)
+{
+    auto itf = stats.valuesPerType.find(typeName);
+    if (itf == stats.valuesPerType.end())
+        itf = stats.valuesPerType.emplace(std::string(typeName), 0).first;
+    itf->second += count;
+}
+
+// Deeper tables are an error rather than a stack overflow
+static constexpr size_t maxTableDepth = 256;
+
+// `WithStats` builds a separate instantiation of the parser that fills `stats`, the regular one doesn't pay for it
+template<bool WithStats>
+static EntryResult parseView(std::string_view& view, const ParserSuite& psuite, ParseStats* stats, size_t depth,
+                             ShapeRegistry& shapes, edat::Table& res);
+
+// Values of an array up to its closing ']', possibly over several lines.
+// Arrays with several dimensions may group their values with inner brackets (`[ ["1", "2"], ["3", "4"] ]`),
+// they're only checked to add up to the declared size. A dynamic outer dimension is filled in from the count.
+static bool parseArrayValues(std::string_view& view, ArraySpec& spec, const char*& lineStart, std::vector<std::string_view>& values)
+{
+    skipWhitespace(view);
+    if (!skipArrayStart(view))
+    {
+        reportError("no array start '['", lineStart, view);
+        return false;
+    }
+    size_t openGroups = 0;
+    while (true)
     {
         skipWhitespace(view);
-        if (skipEndOfTable(view)) // We've exhausted that table
-            return res;
-        if (skipEndOfLine(view))
+        if (skipLineBreak(view))
+        {
+            lineStart = view.data();
+            continue;
+        }
+        if (spec.rank > 1 && skipArrayStart(view))
+        {
+            openGroups++;
+            continue;
+        }
+        if (skipArrayEnd(view))
+        {
+            if (openGroups == 0)
+                break;
+            openGroups--;
+            skipWhitespace(view);
+            skipArrayElementsSeparator(view);
+            continue;
+        }
+        if (view.empty())
+        {
+            reportError("no array end ']'", lineStart, view);
+            return false;
+        }
+        values.push_back(parseValue(view));
+        skipArrayElementsSeparator(view); // this is optional actually
+    }
+
+    size_t innerSize = 1;
+    for (size_t dim = 1; dim < spec.rank; ++dim)
+        innerSize *= spec.extents[dim];
+    if (spec.extents[0] == 0)
+    {
+        if (values.size() % innerSize != 0)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "%zu values don't fill whole rows of %zu", values.size(), innerSize);
+            reportError(message, lineStart, view);
+            return false;
+        }
+        if (spec.rank > 1)
+            spec.extents[0] = values.size() / innerSize;
+    }
+    else if (values.size() / innerSize != spec.extents[0] || values.size() % innerSize != 0)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "array has %zu values, expected %zu", values.size(), spec.extents[0] * innerSize);
+        reportError(message, lineStart, view);
+        return false;
+    }
+    return true;
+}
+
+// Start of the line `pos` is on, not looking further back than `from`
+static const char* findLineStart(const char* from, const char* pos)
+{
+    while (pos > from && !isLineBreak(pos[-1]))
+        pos--;
+    return pos;
+}
+
+// Built in type of arrays of tables: `items:table[] = [ { ... }, { ... } ]`, stored as TableArray
+static constexpr std::string_view tableArrayTypeName = "table";
+
+// Elements are tables spanning any number of lines, separated with optional commas.
+// `expectedCount` is the declared size, 0 for `table[]`
+template<bool WithStats>
+static EntryResult parseTableArray(std::string_view& view, const ParserSuite& psuite, edat::Table& res, std::string_view name,
+                                   const char*& lineStart, ParseStats* stats, size_t depth, ShapeRegistry& shapes, size_t expectedCount)
+{
+    skipWhitespace(view);
+    if (!skipArrayStart(view))
+    {
+        reportError("no array start '['", lineStart, view);
+        return EntryResult::Error;
+    }
+    if (depth + 1 >= maxTableDepth)
+    {
+        reportError("tables are nested too deep", lineStart, view);
+        return EntryResult::Error;
+    }
+    const char* keyLineStart = lineStart;
+    std::vector<edat::Table> elements;
+    EntryResult result = EntryResult::Continue;
+    while (true)
+    {
+        skipWhitespace(view);
+        if (skipLineBreak(view))
         {
-            // Just an empty string
             lineStart = view.data();
             continue;
         }
-        auto [name, typeName, arraySize] = parseKey(view);
-        if (!typeName.empty()) // not a table
+        if (skipArrayEnd(view))
+            break;
+        if (view.empty())
         {
-            if (!skipAssignmentOp(view))
+            reportError("no array end ']'", lineStart, view);
+            result = EntryResult::Error;
+            break;
+        }
+        if (!skipStartOfTable(view))
+        {
+            reportError("no table start '{' in an array of tables", lineStart, view);
+            result = EntryResult::Error;
+            break;
+        }
+        elements.emplace_back();
+        EntryResult elementResult;
+        {
+            EDAT_TRACE_SCOPE_DETAIL("table", name);
+            elementResult = parseView<WithStats>(view, psuite, stats, depth + 1, shapes, elements.back());
+        }
+        shapes.intern(elements.back());
+        lineStart = findLineStart(keyLineStart, view.data());
+        if (elementResult == EntryResult::Error)
+        {
+            result = EntryResult::Error;
+            break;
+        }
+        skipWhitespace(view);
+        skipArrayElementsSeparator(view);
+    }
+    if (result != EntryResult::Error && expectedCount != 0 && elements.size() != expectedCount)
+    {
+        char message[128];
+        snprintf(message, sizeof(message), "array has %zu tables, expected %zu", elements.size(), expectedCount);
+        reportError(message, lineStart, view);
+        result = EntryResult::Error;
+    }
+
+    // Whatever was parsed before an error is kept, like for subtables
+    if constexpr (WithStats)
+    {
+        stats->arrays++;
+        stats->tables += elements.size();
+        countValues(*stats, tableArrayTypeName, elements.size());
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        res.set<TableArray>(name, TableArray::fromTables(std::move(elements)));
+        stats->insertionSeconds += ParseStats::secondsSince(start);
+    }
+    else
+        res.set<TableArray>(name, TableArray::fromTables(std::move(elements)));
+    return result;
+}
+
+// Parses a single entry (or skips an empty line), `lineStart` is kept up to date for error reporting.
+// Every entry that doesn't end the table consumes some input, so the loops over entries always make progress.
+// Finished subtables share their shapes through `shapes` right away, so the duplicates are freed early.
+template<bool WithStats>
+static EntryResult parseEntry(std::string_view& view, const ParserSuite& psuite, edat::Table& res, const char*& lineStart,
+                              ParseStats* stats, size_t depth, ShapeRegistry& shapes)
+{
+    skipWhitespace(view);
+    if (skipEndOfTable(view)) // We've exhausted that table
+        return EntryResult::EndOfTable;
+    if (skipEndOfLine(view))
+    {
+        // Just an empty string
+        lineStart = view.data();
+        return EntryResult::Continue;
+    }
+    auto [name, typeName, arraySpec] = parseKey(view);
+    if constexpr (WithStats)
+        stats->keys++;
+    if (!typeName.empty()) // not a table
+    {
+        if (!arraySpec.valid)
+        {
+            char message[128];
+            snprintf(message, sizeof(message), "wrong array size (up to %zu dimensions, only the first one can be dynamic)", fixedArrayMaxRank);
+            reportError(message, lineStart, view);
+            return EntryResult::Error;
+        }
+        if (!skipAssignmentOp(view))
+        {
+            reportError("no assignment operator '=' after type", lineStart, view);
+            return EntryResult::Error;
+        }
+        if (arraySpec.rank > 0 && typeName == tableArrayTypeName)
+        {
+            if (arraySpec.rank > 1)
             {
-                reportError("no assignment operator '=' after type", lineStart, view);
-                return res;
+                reportError("arrays of tables have a single dimension", lineStart, view);
+                return EntryResult::Error;
             }
-            if (arraySize >= 0)
+            if (parseTableArray<WithStats>(view, psuite, res, name, lineStart, stats, depth, shapes, arraySpec.extents[0]) == EntryResult::Error)
+                return EntryResult::Error;
+        }
+        else if (arraySpec.rank > 0)
+        {
+            std::vector<std::string_view> stringViewArray;
+            const char* entryLineStart = lineStart;
+            if (!parseArrayValues(view, arraySpec, lineStart, stringViewArray))
+                return EntryResult::Error;
+            const std::span<const size_t> extents(arraySpec.extents.data(), arraySpec.rank);
+            if (const TypeParser* parser = getTypeParser(typeName, psuite))
             {
-                skipWhitespace(view);
-                if (!skipArrayStart(view))
-                    printf("Error: no array start\n");
-                std::vector<std::string_view> stringViewArray;
-                while (!skipArrayEnd(view))
+                if (!checkValues(*parser, typeName, stringViewArray, entryLineStart, view))
+                    return EntryResult::Error;
+                if constexpr (WithStats)
                 {
-                    std::string_view val = parseValue(view);
-                    stringViewArray.push_back(val);
-                    skipArrayElementsSeparator(view); // this is optional actually
-                    skipWhitespace(view);
+                    stats->arrays++;
+                    countValues(*stats, typeName, stringViewArray.size());
+                    if (arraySpec.rank > 1)
+                        parser->parseFixedArrayTimed(name, stringViewArray, extents, res, *stats);
+                    else
+                        parser->parseArrayTimed(name, stringViewArray, res, *stats);
                 }
-                if (TypeParser* parser = getTypeParser(typeName, psuite))
+                else if (arraySpec.rank > 1)
+                    parser->parseFixedArray(name, stringViewArray, extents, res);
+                else
                     parser->parseArray(name, stringViewArray, res);
-                skipWhitespace(view);
             }
-            else
+            skipWhitespace(view);
+        }
+        else
+        {
+            std::string_view val = parseValue(view);
+            if (const TypeParser* parser = getTypeParser(typeName, psuite))
             {
-                std::string_view val = parseValue(view);
-                if (TypeParser* parser = getTypeParser(typeName, psuite))
+                if (!checkValues(*parser, typeName, std::span(&val, 1), lineStart, view))
+                    return EntryResult::Error;
+                if constexpr (WithStats)
+                {
+                    countValues(*stats, typeName, 1);
+                    parser->parseValueTimed(name, val, res, *stats);
+                }
+                else
                     parser->parseValue(name, val, res);
             }
         }
-        else
+    }
+    else
+    {
+        std::string_view copyFrom = parseCopyExpression(view);
+        edat::Table subTable;
+        if (!copyFrom.empty())
         {
-            std::string_view copyFrom = parseCopyExpression(view);
-            edat::Table subTable;
-            if (!copyFrom.empty())
+            res.get<Table>(copyFrom, [&](const edat::Table& tbl)
             {
-                res.get<Table>(copyFrom, [&](const edat::Table& tbl)
+                EDAT_TRACE_SCOPE_DETAIL("clone", copyFrom);
+                if constexpr (WithStats)
                 {
+                    ParseStats::Clock::time_point start = ParseStats::Clock::now();
                     subTable = cloneTable(tbl);
-                });
-                skipWhitespace(view);
-            }
-            if (!skipAssignmentOp(view))
-            {
-                reportError("wrong format for table", lineStart, view);
-                return res;
-            }
-            skipWhitespace(view);
-            if (skipEndOfLine(view))
-                lineStart = view.data();
+                    stats->cloneSeconds += ParseStats::secondsSince(start);
+                    stats->clones++;
+                    stats->bytesCopied += subTable.memoryBytes();
+                }
+                else
+                    subTable = cloneTable(tbl);
+            });
             skipWhitespace(view);
-            if (!skipStartOfTable(view))
-            {
-                reportError("wrong format for table", lineStart, view);
-                return res;
-            }
-            edat::Table resSubTable = parseView(view, psuite, &subTable);
-            res.set<edat::Table>(name, std::move(resSubTable));
         }
-        skipWhitespace(view);
-        if (!skipEndOfAssignment(view))
+        if (!skipAssignmentOp(view))
         {
-            if (!skipEndOfLine(view))
-            {
-                reportError("no end of assignment", lineStart, view);
-                return res;
-            }
+            reportError("wrong format for table", lineStart, view);
+            return EntryResult::Error;
+        }
+        skipWhitespace(view);
+        if (skipEndOfLine(view))
             lineStart = view.data();
+        skipWhitespace(view);
+        if (!skipStartOfTable(view))
+        {
+            reportError("wrong format for table", lineStart, view);
+            return EntryResult::Error;
+        }
+        if (depth + 1 >= maxTableDepth)
+        {
+            reportError("tables are nested too deep", lineStart, view);
+            return EntryResult::Error;
+        }
+        // The copy is filled further in place, no need to clone it once more
+        const std::string_view tableStart(view.data() - 1, view.size() + 1); // at the '{'
+        EntryResult subResult;
+        {
+            EDAT_TRACE_SCOPE_DETAIL("table", name);
+            subResult = parseView<WithStats>(view, psuite, stats, depth + 1, shapes, subTable);
+        }
+        shapes.intern(subTable);
+        // Whatever was parsed before an error is kept, like on the top level
+        if constexpr (WithStats)
+        {
+            stats->tables++;
+            ParseStats::Clock::time_point start = ParseStats::Clock::now();
+            res.set<edat::Table>(name, std::move(subTable));
+            stats->insertionSeconds += ParseStats::secondsSince(start);
+        }
+        else
+            res.set<edat::Table>(name, std::move(subTable));
+        if (subResult == EntryResult::Error)
+            return EntryResult::Error;
+        if (subResult == EntryResult::Continue) // the input ran out, e.g. a truncated file
+        {
+            reportError("no table end '}' for this one", lineStart, tableStart);
+            return EntryResult::Error;
         }
     }
-    return res;
+    skipWhitespace(view);
+    // The closing brace of a table ends its last entry too, `{ a:int = "1" }` fits on one line
+    if (!skipEndOfAssignment(view) && !view.starts_with('}'))
+    {
+        if (!skipEndOfLine(view))
+        {
+            reportError("no end of assignment", lineStart, view);
+            return EntryResult::Error;
+        }
+        lineStart = view.data();
+    }
+    return EntryResult::Continue;
 }
 
-edat::Table parseString(const std::string& input, const ParserSuite& psuite)
+// TODO: better error reporting (custom streams, with cerr as default one)
+// TODO: comments parsing
+// TODO: support unquoted values
+// TODO: check for formatting better
+// TODO: proper return if encountering an error
+// TODO: check for memory leaks
+// Returns how the table ended: EndOfTable on '}', Error or Continue if the input ran out
+template<bool WithStats>
+static EntryResult parseView(std::string_view& view, const ParserSuite& psuite, ParseStats* stats, size_t depth,
+                             ShapeRegistry& shapes, edat::Table& res)
 {
+    const char* lineStart = view.data();
+    while (view.size() > 0)
+    {
+        const EntryResult entryRes = parseEntry<WithStats>(view, psuite, res, lineStart, stats, depth, shapes);
+        if (entryRes != EntryResult::Continue)
+            return entryRes;
+    }
+    return EntryResult::Continue;
+}
+
+// Optimizing the layout gives every table its own shape, they're shared again afterwards
+static void applyLayoutProfile(edat::Table& res, const ParserSuite& psuite)
+{
+    if (psuite.layoutProfile.hits.empty())
+        return;
+    res.optimizeLayout(psuite.layoutProfile);
+    ShapeRegistry shapes;
+    res.shareShapes(shapes);
+}
+
+IncrementalParser::IncrementalParser(std::string_view input, const ParserSuite& psuite)
+    : view(input), lineStart(input.data()), psuite(psuite)
+{
+}
+
+bool IncrementalParser::step(size_t budget)
+{
+    if (done)
+        return false;
+    const char* stepStart = view.data();
+    while (!done && size_t(view.data() - stepStart) < budget)
+        done = view.empty() || parseEntry<false>(view, psuite, result, lineStart, nullptr, 0, shapes) != EntryResult::Continue;
+    if (done)
+    {
+        applyLayoutProfile(result, psuite);
+        shapes.shapes.clear();
+    }
+    return !done;
+}
+
+bool tryParseString(const std::string& input, const ParserSuite& psuite, edat::Table& res, ParseStats* stats)
+{
+    EDAT_TRACE_SCOPE("parseString");
     std::string_view view = input;
-    return parseView(view, psuite);
+    // Tables with the same keys (siblings, copies made with `<-` that weren't extended) end up with a single shape
+    ShapeRegistry shapes;
+    EntryResult result;
+    if (!stats)
+        result = parseView<false>(view, psuite, nullptr, 0, shapes, res);
+    else
+    {
+        // Scanning is whatever is left after the measured phases
+        const double measuredBefore = stats->conversionSeconds + stats->insertionSeconds + stats->cloneSeconds;
+        ParseStats::Clock::time_point start = ParseStats::Clock::now();
+        result = parseView<true>(view, psuite, stats, 0, shapes, res);
+        const double measured = stats->conversionSeconds + stats->insertionSeconds + stats->cloneSeconds - measuredBefore;
+        stats->scanSeconds += std::max(0.0, ParseStats::secondsSince(start) - measured);
+        stats->bytesScanned += input.size() - view.size();
+    }
+    applyLayoutProfile(res, psuite);
+    // A '}' without a table to close stops the parse just like an error does
+    return result == EntryResult::Continue;
 }
 
-edat::Table parseFile(std::filesystem::path path, const ParserSuite& psuite)
+edat::Table parseString(const std::string& input, const ParserSuite& psuite, ParseStats* stats)
 {
-    size_t fsize = std::filesystem::file_size(path);
-    FILE* f = fopen(path.string().c_str(), "rb");
-    std::string fileBuffer; fileBuffer.resize(fsize);
-    fread(fileBuffer.data(), 1, fsize, f);
+    edat::Table res;
+    tryParseString(input, psuite, res, stats);
+    return res;
+}
+
+bool readFile(const std::filesystem::path& path, std::string& out)
+{
+    EDAT_TRACE_SCOPE("readFile");
+    std::error_code ec;
+    size_t fsize = std::filesystem::file_size(path, ec);
+    FILE* f = ec ? nullptr : fopen(path.string().c_str(), "rb");
+    if (!f)
+    {
+        printf("Error: can't open file '%s'\n", path.string().c_str());
+        return false;
+    }
+    out.resize(fsize);
+    size_t readBytes = fread(out.data(), 1, fsize, f);
     fclose(f);
+    out.resize(readBytes);
+    return true;
+}
+
+edat::Table parseFile(std::filesystem::path path, const ParserSuite& psuite, ParseStats* stats)
+{
+    EDAT_TRACE_SCOPE_DETAIL("parseFile", path.string());
+    std::string fileBuffer;
+    ParseStats::Clock::time_point start = ParseStats::Clock::now();
+    const bool read = readFile(path, fileBuffer);
+    if (stats)
+        stats->ioSeconds += ParseStats::secondsSince(start);
+    if (!read)
+        return edat::Table{};
+
+    return edat::parseString(fileBuffer, psuite, stats);
+}
+
+std::vector<edat::Table> parseFiles(std::span<const std::filesystem::path> paths, const ParserSuite& psuite, size_t threads)
+{
+    std::vector<edat::Table> res(paths.size());
+    parallelFor(paths.size(), threads, [&](size_t idx)
+    {
+        res[idx] = parseFile(paths[idx], psuite);
+    });
+    return res;
+}
+
+void printParseStats(const ParseStats& stats)
+{
+    printf("Parsed %llu bytes: %llu keys, %llu tables, %llu arrays\n", (unsigned long long)stats.bytesScanned,
+           (unsigned long long)stats.keys, (unsigned long long)stats.tables, (unsigned long long)stats.arrays);
+    for (const auto& [typeName, count] : stats.valuesPerType)
+        printf("  %s: %llu values\n", typeName.c_str(), (unsigned long long)count);
+    printf("  %llu clones, %llu bytes copied\n", (unsigned long long)stats.clones, (unsigned long long)stats.bytesCopied);
+    printf("  io %.3fms, scan %.3fms, conversion %.3fms, insertion %.3fms, clone %.3fms\n", stats.ioSeconds * 1e3,
+           stats.scanSeconds * 1e3, stats.conversionSeconds * 1e3, stats.insertionSeconds * 1e3, stats.cloneSeconds * 1e3);
+}
+
+bool parseBool(const std::string_view& str)
+{
+    return str == "true" || str == "1" || str == "yes" || str == "on";
+}
 
-    return edat::parseString(fileBuffer, psuite);
+bool saveProfile(const AccessProfile& profile, const std::filesystem::path& path)
+{
+    FILE* f = fopen(path.string().c_str(), "wb");
+    if (!f)
+    {
+        printf("Error: can't open '%s' for writing\n", path.string().c_str());
+        return false;
+    }
+    // Hottest first, easier to read
+    std::vector<std::pair<uint64_t, const std::string*>> entries;
+    for (const auto& [name, hits] : profile.hits)
+        entries.emplace_back(hits, &name);
+    std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) { return a.first > b.first || (a.first == b.first && *a.second < *b.second); });
+    for (const auto& [hits, name] : entries)
+        fprintf(f, "%llu %s\n", (unsigned long long)hits, name->c_str());
+    return fclose(f) == 0;
+}
+
+bool loadProfile(const std::filesystem::path& path, AccessProfile& profile)
+{
+    std::string contents;
+    if (!readFile(path, contents))
+        return false;
+    std::string_view view = contents;
+    while (!view.empty())
+    {
+        std::string_view line = parseUntilEndOfLine(view);
+        skipLineBreak(view);
+        uint64_t hits = 0;
+        auto [ptr, ec] = std::from_chars(line.data(), line.data() + line.size(), hits);
+        std::string_view name(ptr, line.data() + line.size() - ptr);
+        skipWhitespace(name);
+        if (ec != std::errc() || name.empty())
+        {
+            printf("Error: malformed profile line '%.*s' in '%s'\n", int(line.size()), line.data(), path.string().c_str());
+            return false;
+        }
+        profile.hits[std::string(name)] += hits;
+    }
+    return true;
 }
 }
@@ -0,0 +1,709 @@
+#include "shared.h"
+#include "fixed_array.h"
+#include "table_array.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace edat
+{
+
+static size_t appendAligned(std::vector<char>& out, const void* data, size_t size)
+{
+    const size_t offset = (out.size() + 7) & ~size_t(7);
+    out.resize(offset + size);
+    if (size > 0)
+        memcpy(out.data() + offset, data, size);
+    return offset;
+}
+
+// Entry fields are 32 bit, values that don't fit make the whole table unserializable
+static bool fitsFlat(uint64_t value)
+{
+    return value <= flat::maxFieldValue;
+}
+
+// Why a table couldn't be serialized, the output is garbage then
+struct SerializeStatus
+{
+    bool fits = true;
+    std::string unsupportedName; // first value of a type the format has no representation for
+    const char* unsupportedType = nullptr;
+};
+
+static size_t serializeTable(const Table& tbl, std::vector<char>& out, SerializeStatus& status);
+
+// Array payloads, shared by plain and fixed arrays. Fill in type, count and payload of `e`.
+template<typename T>
+static void serializeArray(const std::vector<T>& val, flat::ValueType type, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    e.type = type;
+    status.fits = status.fits && fitsFlat(val.size());
+    e.count = uint32_t(val.size());
+    e.payload = appendAligned(out, val.data(), val.size() * sizeof(T));
+}
+
+static void serializeArray(const std::vector<std::string>& val, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    std::vector<flat::StringRef> refs;
+    for (const std::string& str : val)
+        refs.push_back({appendAligned(out, str.data(), str.size()), str.size()});
+    e.type = flat::ValueType::StringArray;
+    status.fits = status.fits && fitsFlat(val.size());
+    e.count = uint32_t(val.size());
+    e.payload = appendAligned(out, refs.data(), refs.size() * sizeof(flat::StringRef));
+}
+
+static void serializeArray(const BitVector& val, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    e.type = flat::ValueType::BoolArray;
+    status.fits = status.fits && fitsFlat(val.size());
+    e.count = uint32_t(val.size());
+    e.payload = appendAligned(out, val.words.data(), val.words.size() * sizeof(uint64_t));
+}
+
+static void serializeArray(const std::vector<int>& val, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    serializeArray(val, flat::ValueType::IntArray, e, out, status);
+}
+
+static void serializeArray(const std::vector<float>& val, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    serializeArray(val, flat::ValueType::FloatArray, e, out, status);
+}
+
+template<typename T>
+static void serializeFixedArray(const FixedArray<T>& val, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    flat::Entry values = {};
+    serializeArray(val.data, values, out, status);
+    flat::FixedArrayHeader header = {};
+    header.elementType = values.type;
+    header.rank = uint32_t(val.rank);
+    header.count = values.count;
+    header.payload = values.payload;
+    std::copy(val.extents.begin(), val.extents.end(), header.extents);
+    e.type = flat::ValueType::FixedArray;
+    e.count = uint32_t(val.rank);
+    e.payload = appendAligned(out, &header, sizeof(header));
+}
+
+// Fills in the value part of `e`, false if the type has no flat representation
+static bool serializeValue(const ValueStorage& storage, size_t idx, flat::Entry& e, std::vector<char>& out, SerializeStatus& status)
+{
+    const std::type_info& type = storage.type();
+    if (type == typeid(int))
+    {
+        e.type = flat::ValueType::Int;
+        const int val = ((const TypedStorage<int>&)storage).storage[idx];
+        memcpy(&e.payload, &val, sizeof(val));
+    }
+    else if (type == typeid(float))
+    {
+        e.type = flat::ValueType::Float;
+        const float val = ((const TypedStorage<float>&)storage).storage[idx];
+        memcpy(&e.payload, &val, sizeof(val));
+    }
+    else if (type == typeid(bool))
+    {
+        e.type = flat::ValueType::Bool;
+        e.payload = ((const TypedStorage<bool>&)storage).storage[idx] ? 1 : 0;
+    }
+    else if (type == typeid(std::string))
+    {
+        const std::string& val = ((const TypedStorage<std::string>&)storage).storage[idx];
+        e.type = flat::ValueType::String;
+        status.fits = status.fits && fitsFlat(val.size());
+        e.count = uint32_t(val.size());
+        e.payload = appendAligned(out, val.data(), val.size());
+    }
+    else if (type == typeid(std::vector<int>))
+        serializeArray(((const TypedStorage<std::vector<int>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(std::vector<float>))
+        serializeArray(((const TypedStorage<std::vector<float>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(std::vector<std::string>))
+        serializeArray(((const TypedStorage<std::vector<std::string>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(BitVector))
+        serializeArray(((const TypedStorage<BitVector>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(FixedArray<int>))
+        serializeFixedArray(((const TypedStorage<FixedArray<int>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(FixedArray<float>))
+        serializeFixedArray(((const TypedStorage<FixedArray<float>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(FixedArray<bool>))
+        serializeFixedArray(((const TypedStorage<FixedArray<bool>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(FixedArray<std::string>))
+        serializeFixedArray(((const TypedStorage<FixedArray<std::string>>&)storage).storage[idx], e, out, status);
+    else if (type == typeid(Table))
+    {
+        e.type = flat::ValueType::Table;
+        e.payload = serializeTable(((const TypedStorage<Table>&)storage).storage[idx], out, status);
+    }
+    else if (type == typeid(TableArray))
+    {
+        // Element by element, readers rebuild the columns with TableArray::fromTables
+        const TableArray& val = ((const TypedStorage<TableArray>&)storage).storage[idx];
+        std::vector<uint64_t> offsets;
+        offsets.reserve(val.size());
+        for (size_t i = 0; i < val.size(); ++i)
+            offsets.push_back(serializeTable(val.row(i), out, status));
+        e.type = flat::ValueType::TableArray;
+        status.fits = status.fits && fitsFlat(val.size());
+        e.count = uint32_t(val.size());
+        e.payload = appendAligned(out, offsets.data(), offsets.size() * sizeof(uint64_t));
+    }
+    else
+        return false;
+    return true;
+}
+
+static size_t serializeTable(const Table& tbl, std::vector<char>& out, SerializeStatus& status)
+{
+    // Sorted by name so readers can binary search
+    std::vector<const Table::TableRecord*> records;
+    for (const Table::TableRecord& rec : tbl.shape->records)
+        if (rec.storageId < tbl.storages.size())
+            records.push_back(&rec);
+    std::sort(records.begin(), records.end(), [&](const Table::TableRecord* a, const Table::TableRecord* b)
+    {
+        return tbl.shape->names[a->nameId] < tbl.shape->names[b->nameId];
+    });
+
+    std::vector<flat::Entry> entries;
+    entries.reserve(records.size());
+    for (const Table::TableRecord* rec : records)
+    {
+        const std::string& name = tbl.shape->names[rec->nameId];
+        flat::Entry e = {};
+        const size_t nameOffset = appendAligned(out, name.data(), name.size());
+        status.fits = status.fits && fitsFlat(nameOffset) && fitsFlat(name.size());
+        e.nameOffset = uint32_t(nameOffset);
+        e.nameLength = uint32_t(name.size());
+        if (!serializeValue(*tbl.storages[rec->storageId], rec->idx, e, out, status))
+        {
+            // A partial table would silently miss keys on the reading side
+            if (!status.unsupportedType)
+            {
+                status.unsupportedName = name;
+                status.unsupportedType = tbl.storages[rec->storageId]->type().name();
+            }
+            continue;
+        }
+        entries.push_back(e);
+    }
+
+    status.fits = status.fits && fitsFlat(entries.size());
+    flat::TableHeader header = {uint32_t(entries.size()), 0};
+    const size_t offset = appendAligned(out, &header, sizeof(header));
+    appendAligned(out, entries.data(), entries.size() * sizeof(flat::Entry));
+    return offset;
+}
+
+bool serializeFlat(const Table& tbl, std::vector<char>& out)
+{
+    out.clear();
+    // First 8 bytes hold the offset of the root table, it's only known once everything nested is written
+    out.resize(sizeof(uint64_t));
+    SerializeStatus status;
+    const size_t rootOffset = serializeTable(tbl, out, status);
+    memcpy(out.data(), &rootOffset, sizeof(uint64_t));
+    if (status.unsupportedType)
+    {
+        printf("Error: value '%s' has a type the flat format can't hold (%s)\n", status.unsupportedName.c_str(),
+               status.unsupportedType);
+        out.clear();
+        return false;
+    }
+    if (!status.fits)
+    {
+        printf("Error: table is too big for the flat format (32 bit offsets and counts)\n");
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+// The buffer may be rewritten while it's read (see SharedReader::read), so fields are copied out once
+// and checked and used from the copy. Reading them again after the bounds check could see other values.
+template<typename T>
+static T loadOnce(const T* ptr)
+{
+    T res;
+    memcpy(&res, ptr, sizeof(T));
+    return res;
+}
+
+// Root offset is stored in the first 8 bytes, tableOffset 0 refers to it
+static size_t resolveTableOffset(const char* base, size_t size, size_t tableOffset)
+{
+    if (tableOffset != 0)
+        return tableOffset;
+    if (size < sizeof(uint64_t))
+        return size;
+    return size_t(loadOnce((const uint64_t*)base));
+}
+
+static bool inBounds(size_t size, uint64_t offset, uint64_t length)
+{
+    return offset <= size && length <= size - offset;
+}
+
+std::span<const flat::Entry> FlatView::entries() const
+{
+    const size_t offset = resolveTableOffset(base, size, tableOffset);
+    if (!inBounds(size, offset, sizeof(flat::TableHeader)))
+        return {};
+    const size_t count = loadOnce((const flat::TableHeader*)(base + offset)).entryCount;
+    if (!inBounds(size, offset + sizeof(flat::TableHeader), count * sizeof(flat::Entry)))
+        return {};
+    return std::span<const flat::Entry>((const flat::Entry*)(base + offset + sizeof(flat::TableHeader)), count);
+}
+
+size_t FlatView::entryCount() const
+{
+    return entries().size();
+}
+
+const flat::Entry* FlatView::entry(size_t idx) const
+{
+    std::span<const flat::Entry> all = entries();
+    return idx < all.size() ? &all[idx] : nullptr;
+}
+
+std::string_view FlatView::entryName(const flat::Entry& entry) const
+{
+    const flat::Entry e = loadOnce(&entry);
+    if (!inBounds(size, e.nameOffset, e.nameLength))
+        return std::string_view{};
+    return std::string_view(base + e.nameOffset, e.nameLength);
+}
+
+const flat::Entry* FlatView::find(const std::string_view& name) const
+{
+    std::span<const flat::Entry> all = entries();
+    auto itf = std::lower_bound(all.begin(), all.end(), name, [&](const flat::Entry& e, const std::string_view& key)
+    {
+        return entryName(e) < key;
+    });
+    if (itf == all.end() || entryName(*itf) != name)
+        return nullptr;
+    return &*itf;
+}
+
+std::optional<int> FlatView::getInt(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::Int)
+        return std::nullopt;
+    int val;
+    memcpy(&val, &e.payload, sizeof(val));
+    return val;
+}
+
+std::optional<float> FlatView::getFloat(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::Float)
+        return std::nullopt;
+    float val;
+    memcpy(&val, &e.payload, sizeof(val));
+    return val;
+}
+
+std::optional<std::string_view> FlatView::getString(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::String || !inBounds(size, e.payload, e.count))
+        return std::nullopt;
+    return std::string_view(base + e.payload, e.count);
+}
+
+std::optional<std::span<const int>> FlatView::getIntArray(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::IntArray || !inBounds(size, e.payload, uint64_t(e.count) * sizeof(int)))
+        return std::nullopt;
+    return std::span<const int>((const int*)(base + e.payload), e.count);
+}
+
+std::optional<std::span<const float>> FlatView::getFloatArray(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::FloatArray || !inBounds(size, e.payload, uint64_t(e.count) * sizeof(float)))
+        return std::nullopt;
+    return std::span<const float>((const float*)(base + e.payload), e.count);
+}
+
+std::optional<FlatView> FlatView::getTable(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    // Offset 0 is the root pointer, nested tables can never live there. They're written before the table
+    // that holds them, so an offset that isn't below ours is corrupt (and could loop back to us).
+    if (e.type != flat::ValueType::Table || e.payload == 0 || e.payload >= resolveTableOffset(base, size, tableOffset) ||
+        !inBounds(size, e.payload, sizeof(flat::TableHeader)))
+        return std::nullopt;
+    return FlatView(base, size, size_t(e.payload));
+}
+
+std::optional<bool> FlatView::getBool(const std::string_view& name) const
+{
+    const flat::Entry* found = find(name);
+    if (!found)
+        return std::nullopt;
+    const flat::Entry e = loadOnce(found);
+    if (e.type != flat::ValueType::Bool)
+        return std::nullopt;
+    return e.payload != 0;
+}
+
+// Array payloads back into containers, false if they're out of bounds. `type`, `count` and `payload`
+// come from an entry or a fixed array header that was already copied out of the buffer.
+template<typename T>
+static bool readArray(const char* base, size_t size, uint64_t count, uint64_t payload, std::vector<T>& out)
+{
+    if (!inBounds(size, payload, count * sizeof(T)))
+        return false;
+    out.resize(count);
+    if (count > 0)
+        memcpy(out.data(), base + payload, count * sizeof(T));
+    return true;
+}
+
+static bool readArray(const char* base, size_t size, uint64_t count, uint64_t payload, std::vector<std::string>& out)
+{
+    if (!inBounds(size, payload, count * sizeof(flat::StringRef)))
+        return false;
+    const flat::StringRef* refs = (const flat::StringRef*)(base + payload);
+    for (uint64_t j = 0; j < count; ++j)
+    {
+        const flat::StringRef ref = loadOnce(refs + j);
+        if (inBounds(size, ref.offset, ref.length))
+            out.emplace_back(base + ref.offset, ref.length);
+    }
+    return true;
+}
+
+static bool readArray(const char* base, size_t size, uint64_t count, uint64_t payload, BitVector& out)
+{
+    if (!readArray(base, size, (count + 63) / 64, payload, out.words))
+        return false;
+    out.count = count;
+    // Bits past the end have to stay clear, whatever the buffer had there
+    if (count % 64 != 0)
+        out.words.back() &= (uint64_t(1) << (count % 64)) - 1;
+    return true;
+}
+
+static_assert(sizeof(flat::FixedArrayHeader::extents) / sizeof(uint64_t) == fixedArrayMaxRank);
+
+template<typename T>
+static void readFixedArray(const char* base, size_t size, const flat::FixedArrayHeader& header, const std::string_view& name, Table& res)
+{
+    FixedArray<T> arr;
+    arr.rank = header.rank;
+    uint64_t elements = 1;
+    for (size_t dim = 0; dim < arr.rank; ++dim)
+    {
+        arr.extents[dim] = size_t(header.extents[dim]);
+        elements *= header.extents[dim];
+    }
+    if (elements == header.count && readArray(base, size, header.count, header.payload, arr.data))
+        res.set<FixedArray<T>>(name, std::move(arr));
+}
+
+Table FlatView::toTable() const
+{
+    Table res;
+    for (const flat::Entry& entry : entries())
+    {
+        const flat::Entry e = loadOnce(&entry);
+        const std::string_view name = entryName(e);
+        switch (e.type)
+        {
+        case flat::ValueType::Int:
+            if (std::optional<int> val = getInt(name))
+                res.set<int>(name, int(*val));
+            break;
+        case flat::ValueType::Float:
+            if (std::optional<float> val = getFloat(name))
+                res.set<float>(name, float(*val));
+            break;
+        case flat::ValueType::Bool:
+            res.set<bool>(name, e.payload != 0);
+            break;
+        case flat::ValueType::String:
+            if (std::optional<std::string_view> str = getString(name))
+                res.set<std::string>(name, std::string(*str));
+            break;
+        case flat::ValueType::IntArray:
+        {
+            std::vector<int> arr;
+            if (readArray(base, size, e.count, e.payload, arr))
+                res.set<std::vector<int>>(name, std::move(arr));
+            break;
+        }
+        case flat::ValueType::FloatArray:
+        {
+            std::vector<float> arr;
+            if (readArray(base, size, e.count, e.payload, arr))
+                res.set<std::vector<float>>(name, std::move(arr));
+            break;
+        }
+        case flat::ValueType::StringArray:
+        {
+            std::vector<std::string> arr;
+            if (readArray(base, size, e.count, e.payload, arr))
+                res.set<std::vector<std::string>>(name, std::move(arr));
+            break;
+        }
+        case flat::ValueType::BoolArray:
+        {
+            BitVector arr;
+            if (readArray(base, size, e.count, e.payload, arr))
+                res.set<BitVector>(name, std::move(arr));
+            break;
+        }
+        case flat::ValueType::FixedArray:
+        {
+            if (!inBounds(size, e.payload, sizeof(flat::FixedArrayHeader)))
+                break;
+            const flat::FixedArrayHeader header = loadOnce((const flat::FixedArrayHeader*)(base + e.payload));
+            if (header.rank == 0 || header.rank > fixedArrayMaxRank)
+                break;
+            if (header.elementType == flat::ValueType::IntArray)
+                readFixedArray<int>(base, size, header, name, res);
+            else if (header.elementType == flat::ValueType::FloatArray)
+                readFixedArray<float>(base, size, header, name, res);
+            else if (header.elementType == flat::ValueType::BoolArray)
+                readFixedArray<bool>(base, size, header, name, res);
+            else if (header.elementType == flat::ValueType::StringArray)
+                readFixedArray<std::string>(base, size, header, name, res);
+            break;
+        }
+        case flat::ValueType::Table:
+            if (std::optional<FlatView> sub = getTable(name))
+                res.set<Table>(name, sub->toTable());
+            break;
+        case flat::ValueType::TableArray:
+        {
+            std::vector<uint64_t> offsets;
+            if (!readArray(base, size, e.count, e.payload, offsets))
+                break;
+            std::vector<Table> tables;
+            tables.reserve(offsets.size());
+            for (uint64_t offset : offsets)
+            {
+                // Same checks as for nested tables, see getTable
+                if (offset == 0 || offset >= resolveTableOffset(base, size, tableOffset) ||
+                    !inBounds(size, offset, sizeof(flat::TableHeader)))
+                    break;
+                tables.push_back(FlatView(base, size, size_t(offset)).toTable());
+            }
+            if (tables.size() == offsets.size())
+                res.set<TableArray>(name, TableArray::fromTables(std::move(tables)));
+            break;
+        }
+        }
+    }
+    return res;
+}
+
+SharedPublisher::SharedPublisher(std::string name, size_t capacity)
+    : name(std::move(name)), capacity((capacity + 63) & ~size_t(63))
+{
+    // Names are addressed with 32 bit offsets, nothing past that could ever be published
+    if (this->capacity > flat::maxBufferSize)
+    {
+        printf("Error: shared memory slots can hold at most %llu bytes, %zu requested\n",
+               (unsigned long long)flat::maxBufferSize, capacity);
+        return;
+    }
+    int fd = shm_open(this->name.c_str(), O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        printf("Error: can't create shared memory object '%s'\n", this->name.c_str());
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        printf("Error: can't stat shared memory object '%s'\n", this->name.c_str());
+        close(fd);
+        return;
+    }
+
+    // An initialized object may be mapped by readers already: it's taken over as it is, with its slots and
+    // sequence counters. Resetting those could hand readers a torn version, shrinking it would SIGBUS them.
+    size_t existingSize = size_t(st.st_size);
+    bool takeOver = false;
+    if (existingSize >= sizeof(SharedControlBlock))
+    {
+        void* ptr = mmap(nullptr, existingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (ptr == MAP_FAILED)
+        {
+            printf("Error: can't map shared memory object '%s'\n", this->name.c_str());
+            close(fd);
+            return;
+        }
+        const SharedControlBlock* ctrl = (const SharedControlBlock*)ptr;
+        const size_t existingCapacity = size_t(ctrl->slotCapacity);
+        if (ctrl->magic == SharedControlBlock::magicValue &&
+            SharedControlBlock::slotOffset(SharedControlBlock::slotCount, existingCapacity) <= existingSize)
+        {
+            if (existingCapacity < this->capacity)
+            {
+                printf("Error: shared memory object '%s' exists with %zu byte slots, %zu requested (unlink it first)\n",
+                       this->name.c_str(), existingCapacity, this->capacity);
+                munmap(ptr, existingSize);
+                close(fd);
+                return;
+            }
+            takeOver = true;
+            this->capacity = existingCapacity;
+            mapping = (char*)ptr;
+            mappedSize = existingSize;
+        }
+        else
+            munmap(ptr, existingSize);
+    }
+    if (takeOver)
+    {
+        close(fd);
+        return;
+    }
+
+    // Not initialized, so nobody reads it yet. Only ever grown, a bigger object is used as it is
+    mappedSize = std::max(existingSize, SharedControlBlock::slotOffset(SharedControlBlock::slotCount, this->capacity));
+    if (existingSize < mappedSize && ftruncate(fd, off_t(mappedSize)) != 0)
+    {
+        printf("Error: can't resize shared memory object '%s'\n", this->name.c_str());
+        close(fd);
+        return;
+    }
+    void* ptr = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        printf("Error: can't map shared memory object '%s'\n", this->name.c_str());
+        return;
+    }
+    mapping = (char*)ptr;
+
+    SharedControlBlock* ctrl = (SharedControlBlock*)mapping;
+    ctrl->magic = 0; // readers ignore the block until it's initialized
+    ctrl->slotCapacity = this->capacity;
+    ctrl->generation.store(0);
+    ctrl->activeSlot.store(0);
+    for (SharedControlBlock::Slot& slot : ctrl->slots)
+    {
+        slot.sequence.store(0);
+        slot.size.store(0);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    ctrl->magic = SharedControlBlock::magicValue;
+}
+
+SharedPublisher::~SharedPublisher()
+{
+    if (mapping)
+        munmap(mapping, mappedSize);
+}
+
+bool SharedPublisher::publish(const Table& tbl)
+{
+    if (!mapping)
+        return false;
+    if (!serializeFlat(tbl, buffer))
+        return false;
+    if (buffer.size() > capacity)
+    {
+        printf("Error: table needs %zu bytes, shared memory slots only have %zu\n", buffer.size(), capacity);
+        return false;
+    }
+
+    SharedControlBlock* ctrl = (SharedControlBlock*)mapping;
+    const uint32_t slot = (ctrl->activeSlot.load(std::memory_order_relaxed) + 1) % SharedControlBlock::slotCount;
+    SharedControlBlock::Slot& header = ctrl->slots[slot];
+
+    // Odd sequence tells readers still looking at this slot that it's being rewritten. It may be odd already
+    // if a publisher that had the object before died mid-write, the next odd value is used then.
+    const uint64_t writing = (header.sequence.load(std::memory_order_relaxed) + 1) | 1;
+    header.sequence.store(writing, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(mapping + SharedControlBlock::slotOffset(slot, capacity), buffer.data(), buffer.size());
+    header.size.store(buffer.size(), std::memory_order_relaxed);
+    header.sequence.store(writing + 1, std::memory_order_release);
+
+    ctrl->activeSlot.store(slot, std::memory_order_release);
+    ctrl->generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+void SharedPublisher::unlink()
+{
+    shm_unlink(name.c_str());
+}
+
+SharedReader::SharedReader(const std::string& name)
+{
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        printf("Error: can't open shared memory object '%s'\n", name.c_str());
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(SharedControlBlock))
+    {
+        printf("Error: shared memory object '%s' is too small\n", name.c_str());
+        close(fd);
+        return;
+    }
+    void* ptr = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+    {
+        printf("Error: can't map shared memory object '%s'\n", name.c_str());
+        return;
+    }
+
+    const SharedControlBlock* ctrl = (const SharedControlBlock*)ptr;
+    if (ctrl->magic != SharedControlBlock::magicValue ||
+        SharedControlBlock::slotOffset(SharedControlBlock::slotCount, ctrl->slotCapacity) > size_t(st.st_size))
+    {
+        printf("Error: '%s' isn't an initialized edat shared table\n", name.c_str());
+        munmap(ptr, size_t(st.st_size));
+        return;
+    }
+    mapping = (const char*)ptr;
+    mappedSize = size_t(st.st_size);
+}
+
+SharedReader::~SharedReader()
+{
+    if (mapping)
+        munmap((void*)mapping, mappedSize);
+}
+
+}
@@ -0,0 +1,135 @@
+#include "trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Only built with -DEDAT_TRACING=ON
+
+namespace edat::trace
+{
+
+struct Event
+{
+    const char* name;
+    std::string detail;
+    uint64_t startNs;
+    uint64_t endNs;
+};
+
+// Every thread appends to its own buffer, so spans on different threads don't contend.
+// Buffers are owned by the registry as well, events of finished threads stay around until clear()
+struct ThreadBuffer
+{
+    std::mutex mutex; // only contended while exporting or clearing
+    uint32_t tid = 0;
+    std::vector<Event> events;
+};
+
+static std::atomic<bool> tracingEnabled = false;
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ThreadBuffer>> registry;
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+static ThreadBuffer& threadBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->tid = uint32_t(registry.size() + 1);
+        registry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+void start()
+{
+    tracingEnabled.store(true, std::memory_order_relaxed);
+}
+
+void stop()
+{
+    tracingEnabled.store(false, std::memory_order_relaxed);
+}
+
+bool enabled()
+{
+    return tracingEnabled.load(std::memory_order_relaxed);
+}
+
+void clear()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : registry)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+    }
+}
+
+uint64_t nowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count());
+}
+
+void record(const char* name, std::string detail, uint64_t startNs, uint64_t endNs)
+{
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back(Event{name, std::move(detail), startNs, endNs});
+}
+
+static void writeEscaped(FILE* f, std::string_view str)
+{
+    for (char ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+            fprintf(f, "\\%c", ch);
+        else if ((unsigned char)ch < 0x20)
+            fprintf(f, "\\u%04x", ch);
+        else
+            fputc(ch, f);
+    }
+}
+
+bool writeChromeTrace(const std::filesystem::path& path)
+{
+    FILE* f = fopen(path.string().c_str(), "wb");
+    if (!f)
+    {
+        printf("Error: can't open '%s' for writing\n", path.string().c_str());
+        return false;
+    }
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first = true;
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (const std::shared_ptr<ThreadBuffer>& buffer : registry)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        for (const Event& event : buffer->events)
+        {
+            // Complete events ("X"), timestamps are in microseconds
+            fprintf(f, "%s{\"name\": \"%s\", \"cat\": \"edat\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f",
+                    first ? "" : ",\n", event.name, buffer->tid, double(event.startNs) * 1e-3,
+                    double(event.endNs - event.startNs) * 1e-3);
+            if (!event.detail.empty())
+            {
+                fprintf(f, ", \"args\": {\"detail\": \"");
+                writeEscaped(f, event.detail);
+                fprintf(f, "\"}");
+            }
+            fprintf(f, "}");
+            first = false;
+        }
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+}
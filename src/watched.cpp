@@ -0,0 +1,272 @@
+#include "watched.h"
+#include "trace.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <map>
+#include <set>
+#endif
+
+namespace edat
+{
+
+static void updateFileStamp(Watched::WatchedFile& file)
+{
+    std::error_code ec;
+    file.lastWriteTime = std::filesystem::last_write_time(file.path, ec);
+    file.lastSize = std::filesystem::file_size(file.path, ec);
+}
+
+Watched::Watched(std::vector<std::filesystem::path> paths, const ParserSuite& psuite,
+                 std::chrono::milliseconds pollInterval)
+    : psuite(psuite), pollInterval(pollInterval)
+{
+    for (std::filesystem::path& path : paths)
+    {
+        files.emplace_back(std::make_unique<WatchedFile>());
+        files.back()->path = std::move(path);
+    }
+
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 && pipe(stopPipe) != 0)
+    {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+    if (inotifyFd >= 0)
+    {
+        // Watch directories rather than the files themselves, editors and deploy scripts
+        // usually replace files via rename which would silently drop a watch on the file
+        std::map<std::filesystem::path, int> dirWatches;
+        for (const std::unique_ptr<WatchedFile>& file : files)
+        {
+            const std::filesystem::path dir = std::filesystem::absolute(file->path).parent_path();
+            auto itf = dirWatches.find(dir);
+            if (itf == dirWatches.end())
+            {
+                int wd = inotify_add_watch(inotifyFd, dir.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+                if (wd < 0)
+                    printf("Warning: can't watch directory '%s', polling its files instead\n", dir.string().c_str());
+                itf = dirWatches.emplace(dir, wd).first;
+            }
+            file->watchDescriptor = itf->second;
+        }
+    }
+#endif
+
+    // Initial load is synchronous so get() always has something to return.
+    // The watches are in place already, so an edit made while loading triggers a reload.
+    for (size_t i = 0; i < files.size(); ++i)
+        if (!reload(i))
+            publish(*files[i], Table{});
+
+    watcher = std::thread([this]() { watchLoop(); });
+}
+
+Watched::~Watched()
+{
+    {
+        std::lock_guard<std::mutex> lock(stopMutex);
+        stopRequested = true;
+    }
+    stopCondition.notify_all();
+#ifdef __linux__
+    if (stopPipe[1] >= 0)
+    {
+        char ch = 0;
+        (void)!write(stopPipe[1], &ch, 1);
+    }
+#endif
+    if (watcher.joinable())
+        watcher.join();
+#ifdef __linux__
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+    for (int fd : stopPipe)
+        if (fd >= 0)
+            close(fd);
+#endif
+
+    // Nobody can be reading anymore, snapshots handed out earlier keep their own references
+    for (const std::unique_ptr<WatchedFile>& file : files)
+        delete file->current.load();
+    for (Published* published : retired)
+        delete published;
+}
+
+// Handed out once per thread, so concurrent readers start at different hazard slots
+static std::atomic<size_t> nextReaderSlot = 0;
+
+Snapshot Watched::get(size_t fileIdx) const
+{
+    static thread_local const size_t firstSlot = nextReaderSlot.fetch_add(1, std::memory_order_relaxed);
+    const std::atomic<Published*>& current = files[fileIdx]->current;
+    for (size_t i = 0; i < hazardSlots; ++i)
+    {
+        std::atomic<Published*>& slot = hazards[(firstSlot + i) % hazardSlots].published;
+        Published* published = current.load();
+        Published* expected = nullptr;
+        if (!slot.compare_exchange_strong(expected, published))
+            continue;
+        // It may have been retired and reclaimed before the slot was set, only a version that's
+        // still current after being announced is safe to dereference
+        Published* latest;
+        while ((latest = current.load()) != published)
+        {
+            published = latest;
+            slot.store(published);
+        }
+        Snapshot res = published->snapshot;
+        slot.store(nullptr, std::memory_order_release);
+        return res;
+    }
+
+    // More readers in flight than slots, reclamation only happens under the same lock
+    std::lock_guard<std::mutex> lock(publishMutex);
+    return current.load()->snapshot;
+}
+
+bool Watched::reload(size_t fileIdx)
+{
+    WatchedFile& file = *files[fileIdx];
+    EDAT_TRACE_SCOPE_DETAIL("reload", file.path.string());
+    {
+        std::lock_guard<std::mutex> lock(publishMutex);
+        updateFileStamp(file);
+    }
+    std::string fileBuffer;
+    if (!readFile(file.path, fileBuffer))
+        return false;
+
+    // A broken edit (or one caught half written) mustn't replace a good version with a partial table
+    Table tbl;
+    if (!tryParseString(fileBuffer, psuite, tbl))
+    {
+        printf("Warning: '%s' has errors, keeping the previous version\n", file.path.string().c_str());
+        return false;
+    }
+    publish(file, std::move(tbl));
+    return true;
+}
+
+void Watched::publish(WatchedFile& file, Table&& tbl)
+{
+    Published* fresh = new Published{Snapshot(std::move(tbl))};
+
+    std::lock_guard<std::mutex> lock(publishMutex);
+    Published* old = file.current.exchange(fresh);
+    file.generation.fetch_add(1, std::memory_order_release);
+    if (old)
+        retired.push_back(old);
+    reclaimRetired();
+}
+
+// Should be called with publishMutex locked
+void Watched::reclaimRetired()
+{
+    if (retired.empty())
+        return;
+    // Readers that announce a version after this scan see it isn't current anymore and never touch it,
+    // so only the ones found in a slot now have to stay. The watcher retries those on every tick.
+    std::vector<Published*> inUse;
+    for (const HazardSlot& slot : hazards)
+        if (Published* published = slot.published.load())
+            inUse.push_back(published);
+    std::erase_if(retired, [&](Published* published)
+    {
+        if (std::find(inUse.begin(), inUse.end(), published) != inUse.end())
+            return false;
+        delete published;
+        return true;
+    });
+}
+
+bool Watched::pollForChanges(bool unwatchedOnly)
+{
+    bool changed = false;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        WatchedFile& file = *files[i];
+        if (unwatchedOnly && file.watchDescriptor >= 0)
+            continue;
+        std::error_code ec;
+        std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(file.path, ec);
+        if (ec)
+            continue;
+        uintmax_t fileSize = std::filesystem::file_size(file.path, ec);
+        if (ec)
+            continue;
+        {
+            std::lock_guard<std::mutex> lock(publishMutex);
+            if (writeTime == file.lastWriteTime && fileSize == file.lastSize)
+                continue;
+        }
+        changed |= reload(i);
+    }
+    return changed;
+}
+
+void Watched::watchLoop()
+{
+    while (true)
+    {
+#ifdef __linux__
+        if (inotifyFd >= 0)
+        {
+            pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {stopPipe[0], POLLIN, 0}};
+            int ready = poll(fds, 2, int(pollInterval.count()));
+            if (fds[1].revents & POLLIN)
+                return;
+            if (ready > 0 && (fds[0].revents & POLLIN))
+            {
+                // Drain all pending events first, so a burst of writes results in a single reload
+                std::set<size_t> changed;
+                bool overflow = false;
+                alignas(inotify_event) char buffer[4096];
+                ssize_t len;
+                while ((len = read(inotifyFd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char* ptr = buffer; ptr < buffer + len;)
+                    {
+                        const inotify_event* event = (const inotify_event*)ptr;
+                        ptr += sizeof(inotify_event) + event->len;
+                        // Events were dropped, any of the files may have changed since
+                        if (event->mask & IN_Q_OVERFLOW)
+                            overflow = true;
+                        if (event->len == 0)
+                            continue;
+                        std::string_view eventName(event->name);
+                        // Same file name in another watched directory isn't a match
+                        for (size_t i = 0; i < files.size(); ++i)
+                            if (files[i]->watchDescriptor == event->wd && files[i]->path.filename() == eventName)
+                                changed.insert(i);
+                    }
+                }
+                if (overflow)
+                    for (size_t i = 0; i < files.size(); ++i)
+                        changed.insert(i);
+                for (size_t fileIdx : changed)
+                    reload(fileIdx);
+            }
+            // Files in directories that couldn't be watched
+            pollForChanges(true);
+        }
+        else
+#endif
+        {
+            std::unique_lock<std::mutex> lock(stopMutex);
+            if (stopCondition.wait_for(lock, pollInterval, [this]() { return stopRequested; }))
+                return;
+            lock.unlock();
+            pollForChanges();
+        }
+
+        std::lock_guard<std::mutex> lock(publishMutex);
+        reclaimRetired();
+    }
+}
+
+}
@@ -0,0 +1,142 @@
+#include <async.h>
+
+#include <charconv>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "test_common.h"
+
+namespace fs = std::filesystem;
+
+// Callbacks run by whichever of the executor's threads gets to them first
+struct QueueExecutor : public edat::Executor
+{
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::deque<std::function<void()>> queue;
+
+    void post(std::function<void()> fn) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(std::move(fn));
+        }
+        condition.notify_one();
+    }
+
+    void runUntil(const std::atomic<size_t>& remaining)
+    {
+        while (remaining.load() != 0)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (!condition.wait_for(lock, std::chrono::milliseconds(5), [this]() { return !queue.empty(); }))
+                continue;
+            std::function<void()> fn = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            fn();
+        }
+    }
+};
+
+int main()
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+
+    // Files of different sizes, the big ones take several parse steps
+    const fs::path dir = testDirectory("async");
+    constexpr size_t fileCount = 24;
+    std::vector<fs::path> paths;
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        std::string doc;
+        for (size_t j = 0; j < (i + 1) * 200; ++j)
+            doc += "key" + std::to_string(j) + ":int = \"" + std::to_string(i * 100000 + j) + "\"\n";
+        paths.push_back(dir / ("file" + std::to_string(i) + ".edat"));
+        writeTextFile(paths.back(), doc);
+    }
+    paths.push_back(dir / "empty.edat");
+    writeTextFile(paths.back(), "");
+    paths.push_back(dir / "missing.edat");
+
+    QueueExecutor executor;
+    std::vector<edat::Table> results(paths.size());
+    std::atomic<size_t> remaining = paths.size();
+    for (size_t i = 0; i < paths.size(); ++i)
+    {
+        edat::startTask(edat::parseFileAsync(paths[i], psuite, executor, 1024), [&, i](edat::Table tbl)
+        {
+            results[i] = std::move(tbl);
+            remaining--;
+        });
+    }
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t)
+        threads.emplace_back([&]() { executor.runUntil(remaining); });
+    for (std::thread& thread : threads)
+        thread.join();
+
+    for (size_t i = 0; i < fileCount; ++i)
+    {
+        const size_t keys = (i + 1) * 200;
+        EDAT_CHECK(results[i].shape->names.size() == keys);
+        EDAT_CHECK(results[i].getOr<int>("key" + std::to_string(keys - 1), -1) == int(i * 100000 + keys - 1));
+    }
+    EDAT_CHECK(results[fileCount].shape->names.empty());
+    EDAT_CHECK(results[fileCount + 1].shape->names.empty());
+
+    // The layout profile of the suite is applied like it is by parseFile, the hottest key comes first
+    psuite.layoutProfile.hits["key199"] = 10;
+    psuite.layoutProfile.hits["key3"] = 5;
+    std::atomic<size_t> profiledLeft = 1;
+    edat::Table profiled;
+    edat::startTask(edat::parseFileAsync(paths[0], psuite, executor, 256), [&](edat::Table tbl)
+    {
+        profiled = std::move(tbl);
+        profiledLeft--;
+    });
+    executor.runUntil(profiledLeft);
+    EDAT_CHECK(profiled.shape->names.size() == 200);
+    EDAT_CHECK(profiled.shape->names[0] == "key199" && profiled.shape->names[1] == "key3");
+    EDAT_CHECK(profiled.getOr<int>("key199", -1) == 199);
+    const edat::Table direct = edat::parseFile(paths[0], psuite);
+    EDAT_CHECK(direct.shape->names == profiled.shape->names);
+
+    // Plain background reads requested from several threads at once
+    std::atomic<size_t> readsLeft = 64;
+    std::atomic<int> readFailures = 0;
+    std::vector<std::thread> requesters;
+    for (int t = 0; t < 4; ++t)
+    {
+        requesters.emplace_back([&, t]()
+        {
+            for (int i = 0; i < 16; ++i)
+            {
+                const size_t fileIdx = size_t(t * 16 + i) % fileCount;
+                const uintmax_t expected = fs::file_size(paths[fileIdx]);
+                edat::readFileInBackground(paths[fileIdx], [&, expected](std::optional<std::string> contents)
+                {
+                    if (!contents || contents->size() != expected)
+                        readFailures++;
+                    readsLeft--;
+                });
+            }
+        });
+    }
+    for (std::thread& requester : requesters)
+        requester.join();
+    while (readsLeft.load() != 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EDAT_CHECK(readFailures == 0);
+
+    fs::remove_all(dir);
+    return testResult();
+}
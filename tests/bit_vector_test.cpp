@@ -0,0 +1,102 @@
+#include <edat.h>
+
+#include "test_common.h"
+
+// Bits past size() stay zero, the word-wise queries rely on that
+static bool tailIsClear(const edat::BitVector& bits)
+{
+    if (bits.words.size() != (bits.size() + 63) / 64)
+        return false;
+    return bits.size() % 64 == 0 || (bits.words.back() >> (bits.size() % 64)) == 0;
+}
+
+static void testPushPop()
+{
+    edat::BitVector bits;
+    EDAT_CHECK(bits.none() && bits.all() && bits.popcount() == 0);
+    for (size_t i = 0; i < 130; ++i)
+        bits.push_back(i % 3 == 0);
+    EDAT_CHECK(bits.size() == 130 && bits.words.size() == 3 && tailIsClear(bits));
+    EDAT_CHECK(bits.popcount() == 44 && bits.any() && !bits.all());
+    for (size_t i = 0; i < 130; ++i)
+        EDAT_CHECK(bits[i] == (i % 3 == 0));
+
+    bits.pop_back(); // 129 was set
+    EDAT_CHECK(bits.size() == 129 && bits.popcount() == 43 && tailIsClear(bits));
+    while (bits.size() > 64)
+        bits.pop_back();
+    EDAT_CHECK(bits.words.size() == 1 && bits.popcount() == 22 && tailIsClear(bits));
+    while (!bits.empty())
+        bits.pop_back();
+    EDAT_CHECK(bits.words.empty() && bits.none());
+
+    // all() ignores the bits past the end
+    for (size_t i = 0; i < 70; ++i)
+        bits.push_back(true);
+    EDAT_CHECK(bits.all() && bits.popcount() == 70);
+    bits[69] = false;
+    EDAT_CHECK(!bits.all() && bits.any() && tailIsClear(bits));
+}
+
+static void testStorage()
+{
+    edat::TypedStorage<bool> storage;
+    for (size_t i = 0; i < 100; ++i)
+        storage.storage.push_back(i % 2 == 0);
+
+    // The last value (99, false) moves into 10, then the last one (98, true) into 0
+    storage.swapRemove(10);
+    storage.swapRemove(0);
+    EDAT_CHECK(storage.storage.size() == 98 && tailIsClear(storage.storage));
+    EDAT_CHECK(storage.storage[0] && !storage.storage[10] && storage.storage.popcount() == 48);
+    storage.swapRemove(97); // the last one itself
+    EDAT_CHECK(storage.storage.size() == 97 && storage.storage.popcount() == 48);
+
+    std::vector<size_t> order;
+    for (size_t i = 0; i < storage.storage.size(); ++i)
+        order.push_back(storage.storage.size() - 1 - i);
+    edat::BitVector before = storage.storage;
+    storage.reorder(order);
+    EDAT_CHECK(storage.storage.size() == before.size() && tailIsClear(storage.storage));
+    for (size_t i = 0; i < order.size(); ++i)
+        EDAT_CHECK(storage.storage[i] == before[order[i]]);
+}
+
+static void testTableBools()
+{
+    edat::Table tbl;
+    for (int i = 0; i < 100; ++i)
+        tbl.set("flag" + std::to_string(i), i % 4 == 0);
+    tbl.set("other", 1);
+    EDAT_CHECK(tbl.view<bool>().values->popcount() == 25);
+
+    for (int i = 0; i < 100; i += 3)
+        EDAT_CHECK(tbl.erase("flag" + std::to_string(i)));
+    tbl.set("flag1", true); // overwritten in place
+    const edat::Table copy = edat::cloneTable(tbl);
+    tbl.set("flag2", true);
+    tbl.set("flag5", 5); // no longer a bool
+
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string name = "flag" + std::to_string(i);
+        const bool erased = i % 3 == 0;
+        const bool copyExpected = i % 4 == 0 || i == 1;
+        EDAT_CHECK(copy.getOr<bool>(name, false) == (!erased && copyExpected));
+        EDAT_CHECK(copy.findIndex(name).storageId == (erased ? size_t(-1) : copy.findIndex("flag1").storageId));
+        if (i == 5)
+            EDAT_CHECK(tbl.getOr<int>(name, 0) == 5 && !tbl.getOr<bool>(name, false));
+        else
+            EDAT_CHECK(tbl.getOr<bool>(name, false) == (!erased && (copyExpected || i == 2)));
+    }
+    EDAT_CHECK(tbl.view<bool>().size() == 100 - 34 - 1);
+    EDAT_CHECK(tailIsClear(*tbl.view<bool>().values) && tailIsClear(*copy.view<bool>().values));
+}
+
+int main()
+{
+    testPushPop();
+    testStorage();
+    testTableBools();
+    return testResult();
+}
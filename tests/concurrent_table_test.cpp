@@ -0,0 +1,119 @@
+#include <concurrent_table.h>
+
+#include <thread>
+#include <vector>
+
+#include "test_common.h"
+
+// Producers add their own keys and overwrite shared ones while readers look keys up and iterate
+static void testProducersAndReaders()
+{
+    constexpr int producers = 8;
+    constexpr int keysPerProducer = 2000;
+    constexpr int sharedKeys = 16;
+    edat::ConcurrentTable tbl;
+
+    std::atomic<bool> stop = false;
+    std::atomic<int> readerFailures = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 2; ++t)
+    {
+        readers.emplace_back([&, t]()
+        {
+            size_t iter = 0;
+            while (!stop.load())
+            {
+                const int producer = int(iter % producers);
+                const int key = int((iter * 7 + t) % keysPerProducer);
+                const int value = tbl.getOr<int>("p" + std::to_string(producer) + "_" + std::to_string(key), -1);
+                if (value != -1 && value != producer * keysPerProducer + key)
+                    readerFailures++;
+                if (iter % 256 == 0)
+                    tbl.getAll<int>([&](const std::string&, int val) { if (val < 0) readerFailures++; });
+                iter++;
+            }
+        });
+    }
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < producers; ++t)
+    {
+        writers.emplace_back([&, t]()
+        {
+            for (int i = 0; i < keysPerProducer; ++i)
+            {
+                tbl.set("p" + std::to_string(t) + "_" + std::to_string(i), int(t * keysPerProducer + i));
+                tbl.set("shared" + std::to_string(i % sharedKeys), int(i));
+            }
+        });
+    }
+    for (std::thread& writer : writers)
+        writer.join();
+    stop = true;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    EDAT_CHECK(readerFailures == 0);
+    EDAT_CHECK(tbl.size() == size_t(producers * keysPerProducer + sharedKeys));
+    edat::Table res = tbl.toTable();
+    EDAT_CHECK(res.shape->names.size() == size_t(producers * keysPerProducer + sharedKeys));
+    for (int t = 0; t < producers; ++t)
+        EDAT_CHECK(res.getOr<int>("p" + std::to_string(t) + "_17", -1) == t * keysPerProducer + 17);
+    for (int i = 0; i < sharedKeys; ++i)
+        EDAT_CHECK(res.getOr<int>("shared" + std::to_string(i), -1) >= 0);
+}
+
+// Keys flipping between two types on several threads reuse the slots they leave behind
+static void testTypeChanges()
+{
+    constexpr int threads = 4;
+    constexpr int keysPerThread = 8;
+    constexpr int flips = 500;
+    edat::ConcurrentTable tbl;
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < threads; ++t)
+    {
+        writers.emplace_back([&, t]()
+        {
+            for (int i = 0; i < flips; ++i)
+            {
+                for (int k = 0; k < keysPerThread; ++k)
+                {
+                    const std::string name = "flip" + std::to_string(t) + "_" + std::to_string(k);
+                    if (i % 2 == 0)
+                        tbl.set(name, int(i));
+                    else
+                        tbl.set(name, std::to_string(i));
+                    // Readers of another type than the current one just get the default
+                    tbl.getOr<float>(name, 0.f);
+                }
+            }
+        });
+    }
+    for (std::thread& writer : writers)
+        writer.join();
+
+    // Every key holds one slot, a thread can hold one more between taking the new slot and releasing the old
+    const size_t bound = threads * keysPerThread + threads;
+    const size_t intId = tbl.getOrCreateStorageForType<int>();
+    const size_t stringId = tbl.getOrCreateStorageForType<std::string>();
+    EDAT_CHECK(tbl.getTypedStorage<int>(intId)->storage.size() <= bound);
+    EDAT_CHECK(tbl.getTypedStorage<std::string>(stringId)->storage.size() <= bound);
+
+    // Last write of every key was the string one (flips is even)
+    for (int t = 0; t < threads; ++t)
+        for (int k = 0; k < keysPerThread; ++k)
+        {
+            const std::string name = "flip" + std::to_string(t) + "_" + std::to_string(k);
+            EDAT_CHECK(tbl.getOr<std::string>(name, "") == std::to_string(flips - 1));
+            EDAT_CHECK(tbl.getOr<int>(name, -1) == -1);
+        }
+}
+
+int main()
+{
+    testProducersAndReaders();
+    testTypeChanges();
+    return testResult();
+}
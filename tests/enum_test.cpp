@@ -0,0 +1,50 @@
+#include <parsers.h>
+
+#include "test_common.h"
+
+enum class Mode : uint8_t { Off, On, Auto };
+
+static void testValues(const edat::ParserSuite& psuite)
+{
+    const edat::Table tbl = edat::parseString("a:mode = \"on\"\n"
+                                              "b:mode[] = [ \"auto\", \"off\",\n  \"on\" ]\n", psuite);
+    EDAT_CHECK(tbl.getOr<Mode>("a", Mode::Off) == Mode::On);
+    bool found = false;
+    tbl.get<std::vector<Mode>>("b", [&](const std::vector<Mode>& modes)
+    {
+        found = true;
+        EDAT_CHECK(modes == std::vector<Mode>({Mode::Auto, Mode::Off, Mode::On}));
+    });
+    EDAT_CHECK(found);
+    EDAT_CHECK(psuite.findEnum<Mode>("mode")->name(Mode::Auto) == "auto");
+}
+
+// Unknown names fail the entry like other malformed values, nothing (and especially not Mode{}) is stored
+static void testUnknownValues(const edat::ParserSuite& psuite)
+{
+    const edat::Table single = edat::parseString("a:mode = \"on\"\n"
+                                                 "b:mode = \"onn\"\n"
+                                                 "c:mode = \"auto\"\n", psuite);
+    EDAT_CHECK(single.getOr<Mode>("a", Mode::Off) == Mode::On);
+    EDAT_CHECK(single.findIndex("b").storageId == size_t(-1));
+    EDAT_CHECK(single.findIndex("c").storageId == size_t(-1));
+
+    const edat::Table array = edat::parseString("a:mode[] = [ \"on\",\n  \"of\" ]\n", psuite);
+    EDAT_CHECK(array.findIndex("a").storageId == size_t(-1));
+
+    const edat::Table nested = edat::parseString("sub = {\n  a:mode = \"\"\n}\n", psuite);
+    nested.get<edat::Table>("sub", [&](const edat::Table& sub) { EDAT_CHECK(sub.findIndex("a").storageId == size_t(-1)); });
+}
+
+int main()
+{
+    edat::ParserSuite psuite;
+    EDAT_CHECK(psuite.addEnum<Mode>("mode", {{"off", Mode::Off}, {"on", Mode::On}, {"auto", Mode::Auto}}));
+    testValues(psuite);
+    testUnknownValues(psuite);
+
+    // Duplicate names are rejected as a whole, the type stays unregistered
+    EDAT_CHECK(!psuite.addEnum<Mode>("dup", {{"off", Mode::Off}, {"on", Mode::On}, {"off", Mode::Auto}}));
+    EDAT_CHECK(psuite.findEnum<Mode>("dup") == nullptr);
+    return testResult();
+}
@@ -0,0 +1,106 @@
+#include <parsers.h>
+
+#include <charconv>
+
+#include "test_common.h"
+
+static void setupParsers(edat::ParserSuite& psuite)
+{
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    psuite.addLambdaParser<bool>("bool", edat::parseBool);
+}
+
+static const edat::FixedArray<int>* findInts(const edat::Table& tbl, const std::string_view& name)
+{
+    const edat::FixedArray<int>* res = nullptr;
+    tbl.get<edat::FixedArray<int>>(name, [&](const edat::FixedArray<int>& arr) { res = &arr; });
+    return res;
+}
+
+// Values are row-major whether they're grouped by rows or not, view(y, x) and slices agree with that
+static void testRowMajor(const edat::ParserSuite& psuite)
+{
+    const edat::Table tbl = edat::parseString("grouped:int[2][3] = [ [\"0\", \"1\", \"2\"], [\"10\", \"11\", \"12\"] ]\n"
+                                              "flat:int[2][3] = [ \"0\", \"1\", \"2\", \"10\", \"11\", \"12\" ]\n"
+                                              "cube:int[2][2][2] = [\n  [ [\"0\", \"1\"], [\"10\", \"11\"] ],\n"
+                                              "  [ [\"100\", \"101\"], [\"110\", \"111\"] ]\n]\n", psuite);
+    for (const char* name : {"grouped", "flat"})
+    {
+        const edat::FixedArray<int>* arr = findInts(tbl, name);
+        EDAT_CHECK(arr && arr->rank == 2 && arr->extent(0) == 2 && arr->extent(1) == 3);
+        if (!arr)
+            continue;
+        EDAT_CHECK(arr->data == std::vector<int>({0, 1, 2, 10, 11, 12}));
+        for (size_t y = 0; y < 2; ++y)
+            for (size_t x = 0; x < 3; ++x)
+                EDAT_CHECK((*arr)(y, x) == int(y * 10 + x) && arr->view()(y, x) == int(y * 10 + x));
+        const edat::MdView<const int> row = arr->view().slice(1);
+        EDAT_CHECK(row.rank() == 1 && row.size() == 3 && row(2) == 12);
+    }
+    const edat::FixedArray<int>* cube = findInts(tbl, "cube");
+    EDAT_CHECK(cube && cube->rank == 3);
+    if (cube)
+    {
+        EDAT_CHECK((*cube)(1, 0, 1) == 101 && (*cube)(0, 1, 0) == 10);
+        EDAT_CHECK(cube->view().slice(1).slice(1)(0) == 110);
+    }
+}
+
+// The first dimension may be left open and is filled in from the count, whole rows only
+static void testDynamicFirstExtent(const edat::ParserSuite& psuite)
+{
+    const edat::Table tbl = edat::parseString("rows:int[][2] = [ \"1\", \"2\", \"3\", \"4\", \"5\", \"6\" ]\n", psuite);
+    const edat::FixedArray<int>* rows = findInts(tbl, "rows");
+    EDAT_CHECK(rows && rows->extent(0) == 3 && rows->extent(1) == 2 && (*rows)(2, 1) == 6);
+
+    const edat::Table partial = edat::parseString("rows:int[][2] = [ \"1\", \"2\", \"3\" ]\n", psuite);
+    EDAT_CHECK(findInts(partial, "rows") == nullptr);
+}
+
+// Counts that don't match the extents and too many dimensions fail the entry
+static void testErrors(const edat::ParserSuite& psuite)
+{
+    const edat::Table fewer = edat::parseString("a:int[2][2] = [ \"1\", \"2\", \"3\" ]\n", psuite);
+    EDAT_CHECK(findInts(fewer, "a") == nullptr);
+    const edat::Table more = edat::parseString("a:int[2][2] = [ \"1\", \"2\", \"3\", \"4\", \"5\" ]\n", psuite);
+    EDAT_CHECK(findInts(more, "a") == nullptr);
+
+    std::string maxRank = "a:int";
+    for (size_t i = 0; i < edat::fixedArrayMaxRank; ++i)
+        maxRank += "[1]";
+    const edat::Table atLimit = edat::parseString(maxRank + " = [ \"7\" ]\n", psuite);
+    const edat::FixedArray<int>* arr = findInts(atLimit, "a");
+    EDAT_CHECK(arr && arr->rank == edat::fixedArrayMaxRank && arr->data == std::vector<int>({7}));
+    const edat::Table overLimit = edat::parseString(maxRank + "[1] = [ \"7\" ]\n", psuite);
+    EDAT_CHECK(overLimit.findIndex("a").storageId == size_t(-1));
+}
+
+// Bool arrays are packed bits, read by value through operator()
+static void testBools(const edat::ParserSuite& psuite)
+{
+    const edat::Table tbl = edat::parseString("mask:bool[2][2] = [ [\"true\", \"false\"], [\"false\", \"true\"] ]\n", psuite);
+    bool found = false;
+    tbl.get<edat::FixedArray<bool>>("mask", [&](const edat::FixedArray<bool>& mask)
+    {
+        found = true;
+        EDAT_CHECK(mask.rank == 2 && mask.size() == 4 && mask.data.popcount() == 2);
+        EDAT_CHECK(mask(0, 0) && !mask(0, 1) && !mask(1, 0) && mask(1, 1));
+    });
+    EDAT_CHECK(found);
+}
+
+int main()
+{
+    edat::ParserSuite psuite;
+    setupParsers(psuite);
+    testRowMajor(psuite);
+    testDynamicFirstExtent(psuite);
+    testErrors(psuite);
+    testBools(psuite);
+    return testResult();
+}
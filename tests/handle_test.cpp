@@ -0,0 +1,140 @@
+#include <edat.h>
+
+#include "test_common.h"
+
+// Overwriting a value in place keeps the cached pointer, the handle sees the new value
+static void testSetSameKey()
+{
+    edat::Table tbl;
+    tbl.set("a", 1);
+    tbl.set<std::string>("s", "one");
+    edat::Handle<int> a = tbl.handle<int>("a");
+    edat::Handle<std::string> s = tbl.handle<std::string>("s");
+    const int* before = a.get();
+    const uint64_t version = tbl.version;
+
+    tbl.set("a", 2);
+    tbl.set<std::string>("s", "two");
+    EDAT_CHECK(tbl.version == version);
+    EDAT_CHECK(a.get() == before);
+    EDAT_CHECK(a.getOr(-1) == 2);
+    EDAT_CHECK(s.getOr("") == "two");
+
+    // A new key can move values around, the handle follows
+    for (int i = 0; i < 100; ++i)
+        tbl.set("k" + std::to_string(i), int(i));
+    EDAT_CHECK(a.getOr(-1) == 2);
+    EDAT_CHECK(s.getOr("") == "two");
+    EDAT_CHECK(tbl.handle<int>("k99").getOr(-1) == 99);
+}
+
+// Handles to missing keys or the wrong type find nothing until the key shows up
+static void testMissing()
+{
+    edat::Table tbl;
+    tbl.set("a", 1.f);
+    edat::Handle<int> a = tbl.handle<int>("a");
+    edat::Handle<int> b = tbl.handle<int>("b");
+    EDAT_CHECK(!a.get() && a.getOr(-1) == -1);
+    EDAT_CHECK(!b.get());
+    tbl.set("b", 5);
+    EDAT_CHECK(b.getOr(-1) == 5);
+    edat::Handle<int> empty;
+    EDAT_CHECK(empty.table == nullptr);
+}
+
+// Erase, compact and type changes move or drop values, the handle resolves again
+static void testInvalidation()
+{
+    edat::Table tbl;
+    for (int i = 0; i < 10; ++i)
+        tbl.set("k" + std::to_string(i), int(i));
+    edat::Handle<int> first = tbl.handle<int>("k0");
+    edat::Handle<int> last = tbl.handle<int>("k9");
+    edat::Handle<int> middle = tbl.handle<int>("k5");
+
+    tbl.erase("k5");
+    EDAT_CHECK(!middle.get());
+    EDAT_CHECK(first.getOr(-1) == 0);
+    EDAT_CHECK(last.getOr(-1) == 9);
+
+    // The erase swapped the last value into the hole, compaction drops the tombstone
+    tbl.compact();
+    EDAT_CHECK(!middle.get());
+    EDAT_CHECK(first.getOr(-1) == 0);
+    EDAT_CHECK(last.getOr(-1) == 9);
+    for (int i = 0; i < 10; ++i)
+        if (i != 5)
+            EDAT_CHECK(tbl.handle<int>("k" + std::to_string(i)).getOr(-1) == i);
+
+    // Same key with another type: the int handle finds nothing, a float one does
+    tbl.set("k9", 9.5f);
+    EDAT_CHECK(!last.get());
+    EDAT_CHECK(tbl.handle<float>("k9").getOr(-1.f) == 9.5f);
+    EDAT_CHECK(first.getOr(-1) == 0);
+    tbl.set("k9", 10);
+    EDAT_CHECK(last.getOr(-1) == 10);
+
+    // Erased and set again is a new value somewhere else
+    tbl.erase("k5");
+    tbl.set("k5", 55);
+    EDAT_CHECK(middle.getOr(-1) == 55);
+
+    tbl.clear();
+    EDAT_CHECK(!first.get() && !last.get() && !middle.get());
+    tbl.set("k0", 100);
+    EDAT_CHECK(first.getOr(-1) == 100);
+}
+
+// Handles stay with the table object they were made for, a moved from table has nothing left to show
+static void testMovedFrom()
+{
+    edat::Table tbl;
+    tbl.set("a", 1);
+    tbl.set<std::string>("s", "text");
+    edat::Handle<int> a = tbl.handle<int>("a");
+    edat::Handle<std::string> s = tbl.handle<std::string>("s");
+    EDAT_CHECK(a.getOr(-1) == 1);
+
+    edat::Table moved = std::move(tbl);
+    EDAT_CHECK(!a.get());
+    EDAT_CHECK(!s.get());
+    EDAT_CHECK(moved.handle<int>("a").getOr(-1) == 1);
+
+    // The moved from table can be used again
+    tbl.set("a", 2);
+    EDAT_CHECK(a.getOr(-1) == 2);
+    EDAT_CHECK(moved.getOr<int>("a", -1) == 1);
+
+    // Same for move assignment, in both directions
+    edat::Handle<int> target = moved.handle<int>("a");
+    moved = std::move(tbl);
+    EDAT_CHECK(!a.get());
+    EDAT_CHECK(target.getOr(-1) == 2);
+
+    // Nested tables move when the parent gets more table entries
+    edat::Table parent;
+    edat::Table child;
+    child.set("x", 3);
+    parent.set("child", std::move(child));
+    const edat::Table* nested = nullptr;
+    parent.get<edat::Table>("child", [&](const edat::Table& val) { nested = &val; });
+    EDAT_CHECK(nested != nullptr);
+    if (!nested)
+        return;
+    edat::Handle<int> x = nested->handle<int>("x");
+    EDAT_CHECK(x.getOr(-1) == 3);
+    edat::Table other;
+    other.set("x", 4);
+    parent.set("other", std::move(other));
+    parent.get<edat::Table>("child", [&](const edat::Table& val) { EDAT_CHECK(val.handle<int>("x").getOr(-1) == 3); });
+}
+
+int main()
+{
+    testSetSameKey();
+    testMissing();
+    testInvalidation();
+    testMovedFrom();
+    return testResult();
+}
@@ -0,0 +1,173 @@
+#include <edat.h>
+#include <fixed_array.h>
+
+#include "test_common.h"
+
+// Keys of every storage interleaved, so reordering shuffles all of them. Every third one is erased again
+// (leaving tombstones) and some change type, which moves values within and between storages.
+static constexpr int keyCount = 60;
+
+static bool erased(int k) { return k % 3 == 1; }
+static bool retyped(int k) { return k % 7 == 0; }
+
+static bool has(const edat::Table& tbl, const std::string& name)
+{
+    return tbl.findIndex(name).storageId < tbl.storages.size();
+}
+
+static edat::Table makeTable()
+{
+    edat::Table tbl;
+    for (int k = 0; k < keyCount; ++k)
+    {
+        const std::string suffix = std::to_string(k);
+        tbl.set("i" + suffix, int(k));
+        tbl.set("f" + suffix, float(k) + 0.5f);
+        tbl.set("b" + suffix, bool(k % 2 == 0));
+        tbl.set<std::string>("s" + suffix, "str" + suffix);
+        tbl.set("v" + suffix, std::vector<int>(size_t(k % 5), k));
+        edat::FixedArray<int> arr;
+        arr.rank = 1;
+        arr.extents = {2};
+        arr.data = {k, -k};
+        tbl.set("a" + suffix, std::move(arr));
+        if (k % 10 == 0)
+        {
+            edat::Table child;
+            child.set("x", int(k));
+            child.set("y", bool(k % 20 == 0));
+            child.set<std::string>("name", "child" + suffix);
+            tbl.set("t" + suffix, std::move(child));
+        }
+    }
+    for (int k = 0; k < keyCount; ++k)
+    {
+        const std::string suffix = std::to_string(k);
+        if (erased(k))
+            for (const char* prefix : {"i", "f", "b", "s", "v", "a"})
+                tbl.erase(prefix + suffix);
+        else if (retyped(k))
+        {
+            tbl.set("i" + suffix, float(k));
+            tbl.set("b" + suffix, int(k));
+        }
+    }
+    return tbl;
+}
+
+static void checkValues(const edat::Table& tbl, const char* what)
+{
+    size_t failures = 0;
+    auto check = [&](bool ok, const std::string& name)
+    {
+        if (!ok && failures++ < 5)
+            printf("%s: wrong value of '%s'\n", what, name.c_str());
+        EDAT_CHECK(ok);
+    };
+    for (int k = 0; k < keyCount; ++k)
+    {
+        const std::string suffix = std::to_string(k);
+        if (erased(k))
+        {
+            check(!has(tbl, "i" + suffix) && !has(tbl, "b" + suffix) && !has(tbl, "a" + suffix), "erased" + suffix);
+            continue;
+        }
+        if (retyped(k))
+        {
+            check(tbl.getOr<float>("i" + suffix, -1.f) == float(k) && tbl.getOr<int>("i" + suffix, -1) == -1, "i" + suffix);
+            check(tbl.getOr<int>("b" + suffix, -1) == k, "b" + suffix);
+        }
+        else
+        {
+            check(tbl.getOr<int>("i" + suffix, -1) == k, "i" + suffix);
+            check(tbl.getOr<bool>("b" + suffix, k % 2 != 0) == (k % 2 == 0), "b" + suffix);
+        }
+        check(tbl.getOr<float>("f" + suffix, -1.f) == float(k) + 0.5f, "f" + suffix);
+        check(tbl.getOr<std::string>("s" + suffix, "") == "str" + suffix, "s" + suffix);
+        bool found = false;
+        tbl.get<std::vector<int>>("v" + suffix, [&](const std::vector<int>& val) { found = val == std::vector<int>(size_t(k % 5), k); });
+        check(found, "v" + suffix);
+        found = false;
+        tbl.get<edat::FixedArray<int>>("a" + suffix, [&](const edat::FixedArray<int>& val) { found = val.data == std::vector<int>{k, -k}; });
+        check(found, "a" + suffix);
+        if (k % 10 == 0)
+        {
+            found = false;
+            tbl.get<edat::Table>("t" + suffix, [&](const edat::Table& child)
+            {
+                found = child.getOr<int>("x", -1) == k && child.getOr<bool>("y", k % 20 != 0) == (k % 20 == 0) &&
+                        child.getOr<std::string>("name", "") == "child" + suffix;
+            });
+            check(found, "t" + suffix);
+        }
+    }
+
+    // Bulk views name every value after the key it belongs to
+    edat::TypedView<int> ints = tbl.view<int>();
+    for (size_t i = 0; i < ints.size(); ++i)
+        check(tbl.getOr<int>(ints.name(i), ints.values[i] + 1) == ints.values[i], "view " + ints.name(i));
+    edat::TypedView<bool> bools = tbl.view<bool>();
+    for (size_t i = 0; i < bools.size(); ++i)
+        check(tbl.getOr<bool>(bools.name(i), !(*bools.values)[i]) == (*bools.values)[i], "view " + bools.name(i));
+    edat::TypedView<std::string> strings = tbl.view<std::string>();
+    for (size_t i = 0; i < strings.size(); ++i)
+        check(tbl.getOr<std::string>(strings.name(i), "") == strings.values[i], "view " + strings.name(i));
+}
+
+static void testCompact()
+{
+    edat::Table tbl = makeTable();
+    checkValues(tbl, "before compact");
+    const size_t records = tbl.shape->records.size();
+    tbl.compact();
+    EDAT_CHECK(tbl.shape->records.size() < records);
+    checkValues(tbl, "compact");
+}
+
+static void testOptimizeLayout()
+{
+    edat::Table tbl = makeTable();
+    tbl.enableProfiling();
+    // Accesses skewed so that cold keys, hot keys and nested ones all end up in new positions
+    for (int k = keyCount - 1; k >= 0; --k)
+        for (int n = 0; n < k % 4; ++n)
+        {
+            const std::string suffix = std::to_string(k);
+            (void)tbl.getOr<int>("i" + suffix, 0);
+            (void)tbl.getOr<bool>("b" + suffix, false);
+            (void)tbl.getOr<std::string>("s" + suffix, "");
+            tbl.get<edat::Table>("t" + suffix, [](const edat::Table& child) { (void)child.getOr<int>("x", 0); });
+        }
+    edat::AccessProfile profile;
+    tbl.collectProfile(profile);
+    tbl.disableProfiling();
+    EDAT_CHECK(!profile.hits.empty());
+
+    // A copy shares the shape, optimizing one must leave the other alone
+    edat::Table copy = edat::cloneTable(tbl);
+    tbl.optimizeLayout(profile);
+    checkValues(tbl, "optimizeLayout");
+    checkValues(copy, "untouched copy");
+
+    // Hottest first
+    EDAT_CHECK(tbl.shape->names.front() == "i3" || tbl.shape->names.front() == "b3" || tbl.shape->names.front() == "s3" ||
+               tbl.shape->names.front() == "t3" || tbl.shape->names.front() == "f3");
+
+    // Changing the optimized table afterwards keeps working
+    tbl.set("i3", 1000);
+    tbl.set("new", 1);
+    tbl.erase("s3");
+    EDAT_CHECK(tbl.getOr<int>("i3", -1) == 1000 && tbl.getOr<int>("new", -1) == 1 && !has(tbl, "s3"));
+    tbl.set("i3", 3);
+    tbl.set<std::string>("s3", "str3");
+    tbl.erase("new");
+    tbl.optimizeLayout(profile);
+    checkValues(tbl, "second optimizeLayout");
+}
+
+int main()
+{
+    testCompact();
+    testOptimizeLayout();
+    return testResult();
+}
@@ -0,0 +1,142 @@
+#include <table_array.h>
+
+#include "test_common.h"
+
+static size_t typeBytes(const edat::MemoryUsage& usage, const std::type_info& type)
+{
+    for (const edat::MemoryUsage::TypeUsage& typeUsage : usage.types)
+        if (*typeUsage.type == type)
+            return typeUsage.bytes;
+    return 0;
+}
+
+// The parts add up to the total, at every level, and match memoryBytes()
+static void checkConsistent(const edat::Table& tbl)
+{
+    const edat::MemoryUsage usage = tbl.memoryUsage();
+    size_t own = usage.names + usage.records + usage.nameMap + usage.typeHashMap + usage.storageList;
+    for (const edat::MemoryUsage::TypeUsage& typeUsage : usage.types)
+    {
+        // Nested table contents are taken out of the table storage, that must not wrap around
+        EDAT_CHECK(typeUsage.bytes <= tbl.memoryBytes());
+        own += typeUsage.bytes;
+    }
+    EDAT_CHECK(usage.own() == own);
+    size_t total = own;
+    for (const edat::MemoryUsage::SubTableUsage& sub : usage.subTables)
+        total += sub.usage.total();
+    EDAT_CHECK(usage.total() == total);
+    EDAT_CHECK(usage.total() == tbl.memoryBytes());
+    EDAT_CHECK(usage.types.size() == tbl.storages.size());
+    EDAT_CHECK(usage.shapeShares == tbl.shapeShares());
+
+    // Sub tables are listed under their names with their own breakdown
+    size_t subTables = 0;
+    tbl.getAll<edat::Table>([&](const std::string& name, const edat::Table& sub)
+    {
+        bool found = false;
+        for (const edat::MemoryUsage::SubTableUsage& subUsage : usage.subTables)
+            if (subUsage.name == name)
+                found = subUsage.usage.total() == sub.memoryBytes();
+        EDAT_CHECK(found);
+        checkConsistent(sub);
+        subTables++;
+    });
+    EDAT_CHECK(usage.subTables.size() == subTables);
+}
+
+static void testBreakdown()
+{
+    edat::Table empty;
+    checkConsistent(empty);
+
+    edat::Table tbl;
+    for (int i = 0; i < 50; ++i)
+        tbl.set("key" + std::to_string(i), int(i));
+    tbl.set("flag", true);
+    tbl.set<std::string>("long", std::string(200, 'x'));
+    tbl.set("values", std::vector<float>(100, 1.f));
+    edat::Table child;
+    child.set("x", 1);
+    edat::Table grandChild;
+    grandChild.set<std::string>("text", std::string(100, 'y'));
+    child.set("grand", std::move(grandChild));
+    tbl.set("child", std::move(child));
+    std::vector<edat::Table> rows(3);
+    for (edat::Table& row : rows)
+        row.set("id", 1);
+    tbl.set("rows", edat::TableArray::fromTables(std::move(rows)));
+    checkConsistent(tbl);
+
+    const edat::MemoryUsage usage = tbl.memoryUsage();
+    EDAT_CHECK(usage.names > 0 && usage.records > 0 && usage.nameMap > 0 && usage.typeHashMap > 0);
+    EDAT_CHECK(typeBytes(usage, typeid(std::string)) >= 200);
+    EDAT_CHECK(typeBytes(usage, typeid(std::vector<float>)) >= 100 * sizeof(float));
+    EDAT_CHECK(typeBytes(usage, typeid(int)) >= 50 * sizeof(int));
+    EDAT_CHECK(typeBytes(usage, typeid(edat::TableArray)) > 0);
+    EDAT_CHECK(usage.subTables.size() == 1 && usage.subTables[0].name == "child");
+    EDAT_CHECK(usage.subTables.size() == 1 && usage.subTables[0].usage.subTables.size() == 1);
+}
+
+// More content is more memory, in the part that holds it
+static void testGrowth()
+{
+    edat::Table tbl;
+    tbl.set("a", 1);
+    edat::Table child;
+    child.set("x", 1);
+    tbl.set("child", std::move(child));
+    const edat::MemoryUsage before = tbl.memoryUsage();
+
+    for (int i = 0; i < 200; ++i)
+        tbl.set("a_rather_long_key_name_" + std::to_string(i), int(i));
+    const edat::MemoryUsage keys = tbl.memoryUsage();
+    EDAT_CHECK(keys.names > before.names);
+    EDAT_CHECK(keys.records > before.records);
+    EDAT_CHECK(keys.nameMap > before.nameMap);
+    EDAT_CHECK(typeBytes(keys, typeid(int)) > typeBytes(before, typeid(int)));
+    EDAT_CHECK(keys.total() > before.total());
+
+    tbl.set<std::string>("text", std::string(1000, 'z'));
+    const edat::MemoryUsage strings = tbl.memoryUsage();
+    EDAT_CHECK(typeBytes(strings, typeid(std::string)) >= 1000);
+    EDAT_CHECK(strings.total() >= keys.total() + 1000);
+
+    const size_t childBefore = strings.subTables.size() == 1 ? strings.subTables[0].usage.total() : 0;
+    edat::Table bigger;
+    for (int i = 0; i < 100; ++i)
+        bigger.set("x" + std::to_string(i), float(i));
+    tbl.set("child", std::move(bigger));
+    const edat::MemoryUsage nested = tbl.memoryUsage();
+    EDAT_CHECK(nested.subTables.size() == 1);
+    EDAT_CHECK(nested.subTables.size() == 1 && nested.subTables[0].usage.total() > childBefore);
+    EDAT_CHECK(nested.total() > strings.total());
+    checkConsistent(tbl);
+}
+
+// Tables sharing a shape each count their share of it
+static void testSharedShape()
+{
+    edat::Table tbl;
+    for (int i = 0; i < 100; ++i)
+        tbl.set("key" + std::to_string(i), int(i));
+    const edat::MemoryUsage alone = tbl.memoryUsage();
+    edat::Table copy = edat::cloneTable(tbl);
+    const edat::MemoryUsage shared = tbl.memoryUsage();
+    EDAT_CHECK(shared.shapeShares == 2 && copy.memoryUsage().shapeShares == 2);
+    EDAT_CHECK(shared.names == alone.names / 2);
+    EDAT_CHECK(shared.records == alone.records / 2);
+    EDAT_CHECK(shared.nameMap == alone.nameMap / 2);
+    EDAT_CHECK(typeBytes(shared, typeid(int)) == typeBytes(alone, typeid(int)));
+    EDAT_CHECK(tbl.memoryBytes() + copy.memoryBytes() <= 2 * alone.total());
+    checkConsistent(tbl);
+    checkConsistent(copy);
+}
+
+int main()
+{
+    testBreakdown();
+    testGrowth();
+    testSharedShape();
+    return testResult();
+}
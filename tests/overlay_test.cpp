@@ -0,0 +1,74 @@
+#include <overlay.h>
+
+#include "test_common.h"
+
+static edat::Table makeLayer(int value, const std::string& label)
+{
+    edat::Table tbl;
+    tbl.set("value", int(value));
+    tbl.set<std::string>(label, std::string(label));
+    edat::Table sub;
+    sub.set("inner", int(value * 10));
+    sub.set<std::string>(label + "_inner", std::string(label));
+    tbl.set("sub", std::move(sub));
+    return tbl;
+}
+
+static void testLookups()
+{
+    const edat::Table defaults = makeLayer(1, "defaults");
+    const edat::Table overrides = makeLayer(2, "overrides");
+    edat::Overlay overlay;
+    overlay.push(defaults);
+    overlay.push(overrides);
+
+    EDAT_CHECK(overlay.getOr<int>("value", -1) == 2);
+    EDAT_CHECK(overlay.getOr<std::string>("defaults", "") == "defaults");
+    EDAT_CHECK(overlay.getOr<std::string>("overrides", "") == "overrides");
+    EDAT_CHECK(overlay.getOr<float>("value", -1.f) == -1.f); // topmost layer decides, other type
+    EDAT_CHECK(!overlay.contains("missing"));
+
+    const edat::Overlay sub = overlay.sub("sub");
+    EDAT_CHECK(sub.layers.size() == 2);
+    EDAT_CHECK(sub.getOr<int>("inner", -1) == 20);
+    EDAT_CHECK(sub.getOr<std::string>("defaults_inner", "") == "defaults");
+
+    const edat::Table flat = overlay.flatten();
+    EDAT_CHECK(flat.getOr<int>("value", -1) == 2);
+    flat.get<edat::Table>("sub", [&](const edat::Table& flatSub)
+    {
+        EDAT_CHECK(flatSub.getOr<int>("inner", -1) == 20);
+        EDAT_CHECK(flatSub.getOr<std::string>("defaults_inner", "") == "defaults");
+    });
+}
+
+// sub() of snapshot layers stays valid once the parent overlay and every other reference are gone
+static edat::Overlay makeSubOfSnapshots()
+{
+    edat::Overlay overlay;
+    overlay.push(edat::Snapshot(makeLayer(1, "defaults")));
+    overlay.push(edat::Snapshot(makeLayer(2, "overrides")));
+    return overlay.sub("sub");
+}
+
+static void testSubLifetime()
+{
+    const edat::Overlay sub = makeSubOfSnapshots();
+    EDAT_CHECK(sub.layers.size() == 2);
+    EDAT_CHECK(sub.getOr<int>("inner", -1) == 20);
+    EDAT_CHECK(sub.getOr<std::string>("defaults_inner", "") == "defaults");
+    EDAT_CHECK(sub.getOr<std::string>("overrides_inner", "") == "overrides");
+    for (const edat::Overlay::Layer& layer : sub.layers)
+        EDAT_CHECK(layer.owned.table.use_count() == 1);
+
+    // Copies of the child overlay share the snapshots
+    edat::Overlay copy = sub;
+    EDAT_CHECK(copy.getOr<int>("inner", -1) == 20);
+}
+
+int main()
+{
+    testLookups();
+    testSubLifetime();
+    return testResult();
+}
@@ -0,0 +1,95 @@
+#include <parallel.h>
+#include <parsers.h>
+
+#include <charconv>
+#include <stdexcept>
+
+#include "test_common.h"
+
+namespace fs = std::filesystem;
+
+// Every index runs exactly once, with a few slow items so threads run dry and steal
+static void testEveryIndexOnce(size_t count, size_t threads)
+{
+    std::vector<std::atomic<int>> visits(count);
+    edat::parallelFor(count, threads, [&](size_t i)
+    {
+        if (i % 997 == 0)
+        {
+            volatile size_t spin = 0;
+            for (size_t j = 0; j < 20000; ++j)
+                spin = spin + j;
+        }
+        visits[i].fetch_add(1, std::memory_order_relaxed);
+    });
+    size_t wrong = 0;
+    for (const std::atomic<int>& visit : visits)
+        wrong += visit.load() != 1;
+    EDAT_CHECK(wrong == 0);
+}
+
+static void testException()
+{
+    constexpr size_t count = 10000;
+    std::atomic<size_t> processed = 0;
+    bool caught = false;
+    try
+    {
+        edat::parallelFor(count, 4, [&](size_t i)
+        {
+            processed++;
+            if (i == 500)
+                throw std::runtime_error("item 500");
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        caught = true;
+    }
+    EDAT_CHECK(caught);
+    EDAT_CHECK(processed == count);
+}
+
+static void testParseFiles()
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+
+    const fs::path dir = testDirectory("parse_files");
+    std::vector<fs::path> paths;
+    for (int i = 0; i < 32; ++i)
+    {
+        std::string doc;
+        for (int j = 0; j <= i; ++j)
+            doc += "key" + std::to_string(j) + ":int = \"" + std::to_string(i * 1000 + j) + "\"\n";
+        paths.push_back(dir / ("file" + std::to_string(i) + ".edat"));
+        writeTextFile(paths.back(), doc);
+    }
+    paths.push_back(dir / "missing.edat");
+
+    std::vector<edat::Table> tables = edat::parseFiles(paths, psuite, 4);
+    EDAT_CHECK(tables.size() == paths.size());
+    for (int i = 0; i < 32; ++i)
+    {
+        EDAT_CHECK(tables[i].shape->names.size() == size_t(i + 1));
+        EDAT_CHECK(tables[i].getOr<int>("key" + std::to_string(i), -1) == i * 1000 + i);
+    }
+    EDAT_CHECK(tables.back().shape->names.empty());
+    fs::remove_all(dir);
+}
+
+int main()
+{
+    testEveryIndexOnce(0, 4);
+    testEveryIndexOnce(3, 8);
+    testEveryIndexOnce(100000, 1);
+    testEveryIndexOnce(100000, 8);
+    testException();
+    testParseFiles();
+    return testResult();
+}
@@ -0,0 +1,113 @@
+#include <parsers.h>
+
+#include <charconv>
+
+#include "test_common.h"
+
+static const std::string document =
+    "a:int = \"1\"\n"
+    "b:float = \"2.5\"\n"
+    "list:int[] = [ \"1\", \"2\", \"3\" ]\n"
+    "grid:int[2][2] = [ \"1\", \"2\", \"3\", \"4\" ]\n"
+    "t = {\n"
+    "    x:int = \"5\"\n"
+    "    inner = {\n"
+    "        y:float = \"1\"\n"
+    "    }\n"
+    "}\n"
+    "u <- t = {\n"
+    "    z:int = \"6\"\n"
+    "}\n"
+    "items:table[] = [ { id:int = \"1\" } { id:int = \"2\" } ]\n";
+
+static uint64_t valuesOf(const edat::ParseStats& stats, const std::string_view& typeName)
+{
+    auto itf = stats.valuesPerType.find(typeName);
+    return itf == stats.valuesPerType.end() ? 0 : itf->second;
+}
+
+static void checkCounts(const edat::ParseStats& stats, uint64_t times)
+{
+    // a, b, list, grid, t, x, inner, y, u, z, items and the two ids
+    EDAT_CHECK(stats.keys == 13 * times);
+    // t, inner, u and the two elements of items
+    EDAT_CHECK(stats.tables == 5 * times);
+    // list, grid and items
+    EDAT_CHECK(stats.arrays == 3 * times);
+    // a, the 3 + 4 array elements, x, z and the two ids
+    EDAT_CHECK(valuesOf(stats, "int") == 12 * times);
+    EDAT_CHECK(valuesOf(stats, "float") == 2 * times);
+    EDAT_CHECK(valuesOf(stats, "table") == 2 * times);
+    EDAT_CHECK(stats.valuesPerType.size() == 3);
+    EDAT_CHECK(stats.clones == times);
+    EDAT_CHECK(stats.bytesCopied > 0);
+    EDAT_CHECK(stats.bytesScanned == document.size() * times);
+    EDAT_CHECK(stats.scanSeconds >= 0.0 && stats.conversionSeconds >= 0.0 && stats.insertionSeconds >= 0.0);
+    EDAT_CHECK(stats.cloneSeconds >= 0.0);
+}
+
+static void testCounters(const edat::ParserSuite& psuite)
+{
+    edat::ParseStats stats;
+    const edat::Table tbl = edat::parseString(document, psuite, &stats);
+    checkCounts(stats, 1);
+    EDAT_CHECK(stats.ioSeconds == 0.0);
+
+    // The counted parse gives the same table as one without stats
+    const edat::Table plain = edat::parseString(document, psuite);
+    EDAT_CHECK(tbl.getOr<int>("a", -1) == 1 && plain.getOr<int>("a", -1) == 1);
+    EDAT_CHECK(tbl.shape->names == plain.shape->names);
+
+    // Stats add up over several parses
+    edat::parseString(document, psuite, &stats);
+    checkCounts(stats, 2);
+}
+
+// Files count their reading as io, the rest is the same
+static void testFile(const edat::ParserSuite& psuite)
+{
+    const std::filesystem::path path = testDirectory("parse_stats") / "doc.edat";
+    writeTextFile(path, document);
+    edat::ParseStats stats;
+    const edat::Table tbl = edat::parseFile(path, psuite, &stats);
+    checkCounts(stats, 1);
+    EDAT_CHECK(stats.ioSeconds > 0.0);
+    EDAT_CHECK(tbl.getOr<float>("b", -1.f) == 2.5f);
+}
+
+// An empty document counts nothing, a broken one what was parsed up to the error
+static void testEdgeCases(const edat::ParserSuite& psuite)
+{
+    edat::ParseStats empty;
+    edat::parseString("", psuite, &empty);
+    EDAT_CHECK(empty.keys == 0 && empty.tables == 0 && empty.arrays == 0 && empty.bytesScanned == 0);
+    EDAT_CHECK(empty.valuesPerType.empty());
+
+    edat::ParseStats broken;
+    edat::Table tbl;
+    EDAT_CHECK(!edat::tryParseString("a:int = \"1\"\nb:int = \"2\"\nc = {\n", psuite, tbl, &broken));
+    EDAT_CHECK(broken.keys == 3);
+    EDAT_CHECK(valuesOf(broken, "int") == 2);
+    EDAT_CHECK(broken.arrays == 0);
+}
+
+int main()
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    psuite.addLambdaParser<float>("float", [](const std::string_view& str) -> float
+    {
+        float res = 0.f;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    testCounters(psuite);
+    testFile(psuite);
+    testEdgeCases(psuite);
+    return testResult();
+}
@@ -0,0 +1,70 @@
+#include <reduce.h>
+
+#include <thread>
+
+#include "test_common.h"
+
+static edat::Table makeTable(size_t count)
+{
+    edat::Table tbl;
+    for (size_t i = 0; i < count; ++i)
+    {
+        tbl.set("i" + std::to_string(i), int(i % 1000) - 500);
+        tbl.set("f" + std::to_string(i), float(i % 97) * 0.5f);
+    }
+    return tbl;
+}
+
+// Parallel results match a plain sequential pass
+static void checkReductions(const edat::Table& tbl, std::atomic<int>& failures)
+{
+    const edat::TypedView<int> ints = tbl.view<int>();
+    const edat::TypedView<float> floats = tbl.view<float>();
+
+    long long expectedSum = 0;
+    int expectedMin = ints.values[0], expectedMax = ints.values[0];
+    size_t expectedPositive = 0;
+    for (int val : ints.values)
+    {
+        expectedSum += val;
+        expectedMin = std::min(expectedMin, val);
+        expectedMax = std::max(expectedMax, val);
+        expectedPositive += val > 0;
+    }
+    if (edat::sum(ints) != int(expectedSum))
+        failures++;
+    if (edat::min(ints) != expectedMin || edat::max(ints) != expectedMax)
+        failures++;
+    if (edat::count(ints, [](int val) { return val > 0; }) != expectedPositive)
+        failures++;
+    if (edat::sum(std::execution::seq, ints) != edat::sum(std::execution::par, ints))
+        failures++;
+
+    std::vector<size_t> expectedBins(10, 0);
+    for (float val : floats.values)
+        if (val >= 0.f && val < 50.f)
+            expectedBins[std::min<size_t>(9, size_t(val / 5.f))]++;
+    if (edat::histogram(floats, 0.f, 50.f, 10) != expectedBins)
+        failures++;
+}
+
+int main()
+{
+    const edat::Table tbl = makeTable(200000);
+    std::atomic<int> failures = 0;
+    checkReductions(tbl, failures);
+
+    // Several callers reducing the same table at once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+        threads.emplace_back([&]() { checkReductions(tbl, failures); });
+    for (std::thread& thread : threads)
+        thread.join();
+    EDAT_CHECK(failures == 0);
+
+    const edat::Table empty;
+    EDAT_CHECK(!edat::min(empty.view<int>()));
+    EDAT_CHECK(edat::sum(empty.view<float>()) == 0.f);
+    EDAT_CHECK(edat::histogram(empty.view<float>(), 0.f, 1.f, 4) == std::vector<size_t>(4, 0));
+    return testResult();
+}
@@ -0,0 +1,151 @@
+#include <parsers.h>
+
+#include <charconv>
+
+#include "test_common.h"
+
+static edat::Table makePoint(int x, int y)
+{
+    edat::Table tbl;
+    tbl.set("x", int(x));
+    tbl.set("y", int(y));
+    tbl.set<std::string>("name", "p" + std::to_string(x));
+    return tbl;
+}
+
+static const edat::Table* findTable(const edat::Table& tbl, const std::string_view& name)
+{
+    const edat::Table* res = nullptr;
+    tbl.get<edat::Table>(name, [&](const edat::Table& val) { res = &val; });
+    return res;
+}
+
+// Clones share the shape until one of them changes the layout, then they go separate ways
+static void testCopyOnWrite()
+{
+    edat::Table original = makePoint(1, 2);
+    edat::Table a = edat::cloneTable(original);
+    edat::Table b = edat::cloneTable(original);
+    edat::Table untouched = edat::cloneTable(original);
+    EDAT_CHECK(a.shape == original.shape && b.shape == original.shape);
+    EDAT_CHECK(original.shapeShares() == 4);
+
+    // Overwriting values doesn't change the layout, nothing is copied
+    a.set("x", 10);
+    b.set<std::string>("name", "b");
+    EDAT_CHECK(a.shape == original.shape && b.shape == original.shape);
+    EDAT_CHECK(original.getOr<int>("x", -1) == 1 && a.getOr<int>("x", -1) == 10 && b.getOr<int>("x", -1) == 1);
+    EDAT_CHECK(original.getOr<std::string>("name", "") == "p1" && b.getOr<std::string>("name", "") == "b");
+
+    // Extending both copies gives each its own shape with only its own keys
+    a.set("z", 3);
+    b.set("w", 4.f);
+    EDAT_CHECK(a.shape != original.shape && b.shape != original.shape && a.shape != b.shape);
+    EDAT_CHECK(a.getOr<int>("z", -1) == 3 && a.getOr<float>("w", -1.f) == -1.f);
+    EDAT_CHECK(b.getOr<float>("w", -1.f) == 4.f && b.getOr<int>("z", -1) == -1);
+    EDAT_CHECK(original.getOr<int>("z", -1) == -1 && original.getOr<float>("w", -1.f) == -1.f);
+    EDAT_CHECK(original.shape->names.size() == 3);
+    EDAT_CHECK(a.getOr<int>("y", -1) == 2 && b.getOr<int>("y", -1) == 2);
+
+    // The ones that weren't touched still share
+    EDAT_CHECK(untouched.shape == original.shape);
+    EDAT_CHECK(original.shapeShares() == 2);
+
+    // A type change and an erase are layout changes too
+    edat::Table retyped = edat::cloneTable(original);
+    retyped.set("y", 2.5f);
+    EDAT_CHECK(retyped.shape != original.shape);
+    EDAT_CHECK(original.getOr<int>("y", -1) == 2 && retyped.getOr<int>("y", -1) == -1);
+    edat::Table erased = edat::cloneTable(original);
+    erased.erase("name");
+    EDAT_CHECK(erased.shape != original.shape);
+    EDAT_CHECK(original.getOr<std::string>("name", "") == "p1" && erased.getOr<std::string>("name", "none") == "none");
+    EDAT_CHECK(untouched.shape == original.shape);
+
+    // Once alone with its shape a table changes it in place
+    const edat::Shape* own = a.shape.get();
+    a.set("more", 1);
+    EDAT_CHECK(a.shape.get() == own);
+}
+
+// Tables with the same keys of the same types, added in the same order, end up with one shape
+static void testRegistry()
+{
+    edat::ShapeRegistry registry;
+    edat::Table a = makePoint(1, 2);
+    edat::Table b = makePoint(3, 4);
+    edat::Table otherOrder;
+    otherOrder.set("y", 5);
+    otherOrder.set("x", 6);
+    otherOrder.set<std::string>("name", "p6");
+    EDAT_CHECK(a.shape != b.shape);
+
+    registry.intern(a);
+    registry.intern(b);
+    registry.intern(otherOrder);
+    EDAT_CHECK(a.shape == b.shape);
+    EDAT_CHECK(otherOrder.shape != a.shape);
+    EDAT_CHECK(a.getOr<int>("x", -1) == 1 && b.getOr<int>("x", -1) == 3 && otherOrder.getOr<int>("x", -1) == 6);
+
+    // Interned shapes are copied on write like any other shared one
+    b.set("z", 1);
+    EDAT_CHECK(a.shape != b.shape);
+    EDAT_CHECK(a.getOr<int>("z", -1) == -1);
+
+    // Sibling tables nested anywhere share once the parent shares its shapes
+    edat::Table parent;
+    parent.set("first", makePoint(1, 1));
+    parent.set("second", makePoint(2, 2));
+    edat::Table group;
+    group.set("third", makePoint(3, 3));
+    parent.set("group", std::move(group));
+    edat::ShapeRegistry nested;
+    parent.shareShapes(nested);
+    const edat::Table* first = findTable(parent, "first");
+    const edat::Table* second = findTable(parent, "second");
+    const edat::Table* groupTbl = findTable(parent, "group");
+    const edat::Table* third = groupTbl ? findTable(*groupTbl, "third") : nullptr;
+    EDAT_CHECK(first && second && third);
+    if (first && second && third)
+    {
+        EDAT_CHECK(first->shape == second->shape && second->shape == third->shape);
+        EDAT_CHECK(first->getOr<int>("x", -1) == 1 && third->getOr<int>("x", -1) == 3);
+    }
+}
+
+// Parsing shares the shapes of sibling tables and of copies that weren't extended
+static void testParsed()
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    const edat::Table tbl = edat::parseString(
+        "a = { x:int = \"1\"\n y:int = \"2\" }\n"
+        "b = { x:int = \"3\"\n y:int = \"4\" }\n"
+        "c <- a = { x:int = \"5\" }\n"
+        "d <- a = { z:int = \"6\" }\n", psuite);
+    const edat::Table* a = findTable(tbl, "a");
+    const edat::Table* b = findTable(tbl, "b");
+    const edat::Table* c = findTable(tbl, "c");
+    const edat::Table* d = findTable(tbl, "d");
+    EDAT_CHECK(a && b && c && d);
+    if (!a || !b || !c || !d)
+        return;
+    EDAT_CHECK(a->shape == b->shape && a->shape == c->shape);
+    EDAT_CHECK(d->shape != a->shape);
+    EDAT_CHECK(a->getOr<int>("x", -1) == 1 && b->getOr<int>("x", -1) == 3 && c->getOr<int>("x", -1) == 5);
+    EDAT_CHECK(c->getOr<int>("y", -1) == 2);
+    EDAT_CHECK(d->getOr<int>("z", -1) == 6 && d->getOr<int>("y", -1) == 2 && a->getOr<int>("z", -1) == -1);
+}
+
+int main()
+{
+    testCopyOnWrite();
+    testRegistry();
+    testParsed();
+    return testResult();
+}
@@ -0,0 +1,237 @@
+#include <shared.h>
+#include <fixed_array.h>
+#include <table_array.h>
+
+#include <thread>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "test_common.h"
+
+enum class Mode : uint8_t { Off, On };
+
+static edat::Table makeVersion(int gen)
+{
+    edat::Table tbl;
+    tbl.set("gen", int(gen));
+    tbl.set("values", std::vector<int>(size_t(gen % 100), gen));
+    tbl.set<std::string>("name", "version" + std::to_string(gen));
+    return tbl;
+}
+
+// Readers only ever see whole versions while the publisher keeps rewriting the slots
+static void testPublishUnderLoad(const std::string& shmName)
+{
+    edat::SharedPublisher publisher(shmName, 64 * 1024);
+    EDAT_CHECK(publisher.isValid());
+    EDAT_CHECK(publisher.publish(makeVersion(0)));
+    edat::SharedReader reader(shmName);
+    EDAT_CHECK(reader.isValid());
+    if (!publisher.isValid() || !reader.isValid())
+        return;
+
+    constexpr int versions = 2000;
+    std::atomic<bool> stop = false;
+    std::atomic<int> readerFailures = 0;
+    std::atomic<size_t> reads = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 3; ++t)
+    {
+        readers.emplace_back([&]()
+        {
+            int lastGen = 0;
+            while (!stop.load())
+            {
+                std::optional<bool> consistent = reader.read([&](const edat::FlatView& view)
+                {
+                    const int gen = view.getOr<int>("gen", -1);
+                    std::optional<std::span<const int>> values = view.getIntArray("values");
+                    if (gen < lastGen || !values || values->size() != size_t(gen % 100))
+                        return false;
+                    for (int val : *values)
+                        if (val != gen)
+                            return false;
+                    lastGen = gen;
+                    return view.getOr<std::string>("name", "") == "version" + std::to_string(gen);
+                }, std::chrono::seconds(10));
+                if (!consistent || !*consistent)
+                    readerFailures++;
+                reads++;
+            }
+        });
+    }
+    for (int gen = 1; gen <= versions; ++gen)
+        EDAT_CHECK(publisher.publish(makeVersion(gen)));
+    stop = true;
+    for (std::thread& thread : readers)
+        thread.join();
+
+    EDAT_CHECK(readerFailures == 0);
+    EDAT_CHECK(reads > 0);
+    EDAT_CHECK(reader.generation() == uint64_t(versions + 1));
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == versions);
+    EDAT_CHECK(reader.toTable().getOr<std::string>("name", "") == "version" + std::to_string(versions));
+}
+
+// A slot left marked as being written (publisher died mid-write) makes reads give up instead of spinning
+static void testStuckSlot(const std::string& shmName)
+{
+    edat::SharedPublisher publisher(shmName, 4096);
+    EDAT_CHECK(publisher.publish(makeVersion(7)));
+    edat::SharedReader reader(shmName);
+    if (!publisher.isValid() || !reader.isValid())
+        return;
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 7);
+
+    edat::SharedControlBlock* ctrl = (edat::SharedControlBlock*)publisher.mapping;
+    const uint32_t active = ctrl->activeSlot.load();
+    ctrl->slots[active].sequence.fetch_add(1);
+
+    const auto start = std::chrono::steady_clock::now();
+    std::optional<int> res = reader.read([](const edat::FlatView& view) { return view.getOr<int>("gen", -1); },
+                                         std::chrono::milliseconds(20));
+    EDAT_CHECK(!res);
+    EDAT_CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(5));
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == -1);
+}
+
+static void testLimits(const std::string& shmName)
+{
+    // Slots past what 32 bit offsets can address are refused up front
+    edat::SharedPublisher tooBig(shmName, size_t(edat::flat::maxBufferSize) * 2);
+    EDAT_CHECK(!tooBig.isValid());
+
+    std::vector<char> buffer;
+    EDAT_CHECK(edat::serializeFlat(makeVersion(42), buffer));
+    EDAT_CHECK(edat::FlatView(buffer.data(), buffer.size()).getOr<int>("gen", -1) == 42);
+}
+
+template<typename T>
+static const T* find(const edat::Table& tbl, const std::string_view& name)
+{
+    const T* res = nullptr;
+    tbl.get<T>(name, [&](const T& val) { res = &val; });
+    return res;
+}
+
+// The newer value types make it through a snapshot, an enum fails the publish instead of going missing
+static void testValueTypes(const std::string& shmName)
+{
+    edat::Table tbl;
+    tbl.set("on", true);
+    tbl.set("off", false);
+    edat::BitVector bits;
+    for (int i = 0; i < 70; ++i)
+        bits.push_back(i % 3 == 0);
+    tbl.set("bits", edat::BitVector(bits));
+    edat::FixedArray<int> grid;
+    grid.rank = 2;
+    grid.extents = {2, 3};
+    grid.data = {1, 2, 3, 4, 5, 6};
+    tbl.set("grid", edat::FixedArray<int>(grid));
+    edat::FixedArray<bool> flags;
+    flags.rank = 1;
+    flags.extents = {3};
+    flags.data.push_back(true);
+    flags.data.push_back(false);
+    flags.data.push_back(true);
+    tbl.set("flags", edat::FixedArray<bool>(flags));
+    std::vector<edat::Table> rows;
+    for (int i = 0; i < 3; ++i)
+    {
+        edat::Table row;
+        row.set("id", int(i));
+        row.set("enabled", i != 1);
+        rows.push_back(std::move(row));
+    }
+    tbl.set("rows", edat::TableArray::fromTables(std::move(rows)));
+
+    edat::SharedPublisher publisher(shmName, 4096);
+    EDAT_CHECK(publisher.publish(tbl));
+    edat::SharedReader reader(shmName);
+    if (!publisher.isValid() || !reader.isValid())
+        return;
+    EDAT_CHECK(reader.read([](const edat::FlatView& view) { return view.getBool("on"); }) == std::optional<std::optional<bool>>(true));
+    EDAT_CHECK(reader.getOr<bool>("off", true) == false);
+
+    edat::Table copy = reader.toTable();
+    EDAT_CHECK(copy.getOr<bool>("on", false) == true);
+    EDAT_CHECK(copy.getOr<bool>("off", true) == false);
+    const edat::BitVector* bitsCopy = find<edat::BitVector>(copy, "bits");
+    EDAT_CHECK(bitsCopy && *bitsCopy == bits);
+    const edat::FixedArray<int>* gridCopy = find<edat::FixedArray<int>>(copy, "grid");
+    EDAT_CHECK(gridCopy && gridCopy->rank == 2 && gridCopy->extent(0) == 2 && gridCopy->extent(1) == 3);
+    EDAT_CHECK(gridCopy && (*gridCopy)(1, 2) == 6 && gridCopy->data == grid.data);
+    const edat::FixedArray<bool>* flagsCopy = find<edat::FixedArray<bool>>(copy, "flags");
+    EDAT_CHECK(flagsCopy && flagsCopy->rank == 1 && flagsCopy->data == flags.data);
+    const edat::TableArray* rowsCopy = find<edat::TableArray>(copy, "rows");
+    EDAT_CHECK(rowsCopy && rowsCopy->size() == 3);
+    if (rowsCopy && rowsCopy->size() == 3)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            edat::Table row = rowsCopy->row(size_t(i));
+            EDAT_CHECK(row.getOr<int>("id", -1) == i);
+            EDAT_CHECK(row.getOr<bool>("enabled", i == 1) == (i != 1));
+        }
+    }
+
+    // Enums are the user's types, the format has no way to hold them
+    const uint64_t generation = reader.generation();
+    tbl.set("mode", Mode::On);
+    EDAT_CHECK(!publisher.publish(tbl));
+    std::vector<char> buffer;
+    EDAT_CHECK(!edat::serializeFlat(tbl, buffer));
+    EDAT_CHECK(reader.generation() == generation);
+    EDAT_CHECK(reader.getOr<bool>("on", false) == true);
+}
+
+// A second publisher takes the object over as it is, readers that have it mapped keep working
+static void testTakeOver(const std::string& shmName)
+{
+    shm_unlink(shmName.c_str());
+    edat::SharedPublisher first(shmName, 8192);
+    EDAT_CHECK(first.publish(makeVersion(1)));
+    edat::SharedReader reader(shmName);
+    if (!first.isValid() || !reader.isValid())
+        return;
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 1);
+
+    // A smaller capacity reuses the bigger slots and keeps the published version
+    edat::SharedPublisher second(shmName, 1024);
+    EDAT_CHECK(second.isValid());
+    EDAT_CHECK(second.mappedSize == first.mappedSize);
+    EDAT_CHECK(reader.generation() == 1);
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 1);
+    EDAT_CHECK(second.publish(makeVersion(2)));
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 2);
+
+    // A slot left mid-write by the previous publisher gets a fresh odd/even pair
+    edat::SharedControlBlock* ctrl = (edat::SharedControlBlock*)second.mapping;
+    for (edat::SharedControlBlock::Slot& slot : ctrl->slots)
+        if (slot.sequence.load() % 2 == 0)
+            slot.sequence.fetch_add(1);
+    EDAT_CHECK(second.publish(makeVersion(3)));
+    EDAT_CHECK(second.publish(makeVersion(4)));
+    for (edat::SharedControlBlock::Slot& slot : ctrl->slots)
+        EDAT_CHECK(slot.sequence.load() % 2 == 0);
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 4);
+    EDAT_CHECK(reader.generation() == 4);
+
+    // Bigger slots than the object has can't be had without resetting it under the reader
+    edat::SharedPublisher tooBig(shmName, 64 * 1024);
+    EDAT_CHECK(!tooBig.isValid());
+    EDAT_CHECK(reader.getOr<int>("gen", -1) == 4);
+}
+
+int main()
+{
+    const std::string shmName = "/edat_test_shared_" + std::to_string(getpid());
+    testPublishUnderLoad(shmName);
+    testStuckSlot(shmName);
+    testLimits(shmName);
+    testValueTypes(shmName);
+    testTakeOver(shmName);
+    shm_unlink(shmName.c_str());
+    return testResult();
+}
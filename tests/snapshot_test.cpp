@@ -0,0 +1,100 @@
+#include <snapshot.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test_common.h"
+
+static edat::Table makeTable()
+{
+    edat::Table tbl;
+    for (int i = 0; i < 100; ++i)
+        tbl.set("value" + std::to_string(i), int(i));
+    edat::Table sub;
+    sub.set("inner", 42.f);
+    tbl.set("sub", std::move(sub));
+    return tbl;
+}
+
+// Copies of one snapshot are taken, read and dropped on several threads while the original goes away
+static void testConcurrentReaders(bool profiling)
+{
+    edat::Table tbl = makeTable();
+    if (profiling)
+        tbl.enableProfiling();
+    edat::Snapshot original(std::move(tbl));
+
+    std::atomic<int> failures = 0;
+    std::atomic<int> started = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 8; ++t)
+    {
+        edat::Snapshot copy = original;
+        readers.emplace_back([copy = std::move(copy), &failures, &started]()
+        {
+            started++;
+            for (int iter = 0; iter < 2000; ++iter)
+            {
+                edat::Snapshot local = copy;
+                const int idx = iter % 100;
+                if (local.getOr<int>("value" + std::to_string(idx), -1) != idx)
+                    failures++;
+                local.get<edat::Table>("sub", [&](const edat::Table& sub)
+                {
+                    if (sub.getOr<float>("inner", 0.f) != 42.f)
+                        failures++;
+                });
+            }
+        });
+    }
+    while (started.load() < 8)
+        std::this_thread::yield();
+    original = edat::Snapshot();
+    for (std::thread& reader : readers)
+        reader.join();
+    EDAT_CHECK(failures == 0);
+}
+
+// Clones share the shape of the original, each thread changes its own clone (new keys, erase, clear),
+// which must copy the shape first while others still use it and may change it in place once it's the last one
+static void testSharedShapeWriters()
+{
+    const edat::Table original = makeTable();
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 8; ++t)
+    {
+        writers.emplace_back([&original, &failures, t]()
+        {
+            for (int iter = 0; iter < 200; ++iter)
+            {
+                edat::Table tbl = edat::cloneTable(original);
+                tbl.set("thread" + std::to_string(t), int(iter));
+                tbl.erase("value" + std::to_string(iter % 100));
+                if (tbl.getOr<int>("thread" + std::to_string(t), -1) != iter || tbl.getOr<int>("value" + std::to_string(iter % 100), -1) != -1)
+                    failures++;
+                if (iter % 4 == 0)
+                {
+                    tbl.clear();
+                    tbl.set("value0", 7);
+                    if (tbl.getOr<int>("value0", -1) != 7 || tbl.shape->names.size() != 1)
+                        failures++;
+                }
+            }
+        });
+    }
+    for (std::thread& writer : writers)
+        writer.join();
+    EDAT_CHECK(failures == 0);
+    EDAT_CHECK(original.shape->names.size() == 101);
+    EDAT_CHECK(original.getOr<int>("value42", -1) == 42);
+}
+
+int main()
+{
+    testConcurrentReaders(false);
+    testConcurrentReaders(true);
+    testSharedShapeWriters();
+    return testResult();
+}
@@ -0,0 +1,172 @@
+#include <table_array.h>
+#include <parsers.h>
+
+#include <charconv>
+
+#include "test_common.h"
+
+static edat::Table makeItem(int id, bool enabled)
+{
+    edat::Table item;
+    item.set("id", int(id));
+    item.set("weight", float(id) * 0.5f);
+    item.set("enabled", bool(enabled));
+    item.set<std::string>("name", "item" + std::to_string(id));
+    return item;
+}
+
+// Same keys of the same types everywhere, stored as one column per key
+static void testColumnar()
+{
+    std::vector<edat::Table> items;
+    for (int i = 0; i < 70; ++i)
+        items.push_back(makeItem(i, i % 3 == 0));
+    const edat::TableArray arr = edat::TableArray::fromTables(std::move(items));
+    EDAT_CHECK(arr.columnar());
+    EDAT_CHECK(arr.size() == 70);
+    EDAT_CHECK(arr.rows.empty());
+
+    std::span<const int> ids = arr.column<int>("id");
+    std::span<const float> weights = arr.column<float>("weight");
+    std::span<const std::string> names = arr.column<std::string>("name");
+    const edat::BitVector* enabled = arr.bitColumn("enabled");
+    EDAT_CHECK(ids.size() == 70 && weights.size() == 70 && names.size() == 70);
+    EDAT_CHECK(enabled && enabled->size() == 70);
+    for (int i = 0; i < int(ids.size()) && i < int(weights.size()) && i < int(names.size()); ++i)
+    {
+        EDAT_CHECK(ids[size_t(i)] == i);
+        EDAT_CHECK(weights[size_t(i)] == float(i) * 0.5f);
+        EDAT_CHECK(names[size_t(i)] == "item" + std::to_string(i));
+        EDAT_CHECK(!enabled || (*enabled)[size_t(i)] == (i % 3 == 0));
+        EDAT_CHECK(arr.getOr<int>(size_t(i), "id", -1) == i);
+        EDAT_CHECK(arr.getOr<bool>(size_t(i), "enabled", i % 3 != 0) == (i % 3 == 0));
+    }
+    EDAT_CHECK(enabled && enabled->popcount() == 24);
+
+    // Missing keys and the wrong type give nothing
+    EDAT_CHECK(arr.column<int>("missing").empty());
+    EDAT_CHECK(arr.column<float>("id").empty());
+    EDAT_CHECK(arr.bitColumn("id") == nullptr);
+    EDAT_CHECK(arr.getOr<int>(0, "weight", -1) == -1);
+}
+
+// Elements with different keys or types stay separate tables, the column accessors come up empty
+static void testMixedShapes()
+{
+    std::vector<edat::Table> items;
+    items.push_back(makeItem(0, true));
+    items.push_back(makeItem(1, false));
+    edat::Table extraKey = makeItem(2, true);
+    extraKey.set("extra", 5);
+    items.push_back(std::move(extraKey));
+    edat::Table otherType;
+    otherType.set("id", 3.f);
+    items.push_back(std::move(otherType));
+
+    const edat::TableArray arr = edat::TableArray::fromTables(std::move(items));
+    EDAT_CHECK(!arr.columnar());
+    EDAT_CHECK(arr.size() == 4 && arr.rows.size() == 4);
+    EDAT_CHECK(arr.column<int>("id").empty());
+    EDAT_CHECK(arr.bitColumn("enabled") == nullptr);
+    EDAT_CHECK(arr.getOr<int>(1, "id", -1) == 1);
+    EDAT_CHECK(arr.getOr<int>(2, "extra", -1) == 5);
+    EDAT_CHECK(arr.getOr<int>(3, "id", -1) == -1);
+    EDAT_CHECK(arr.getOr<float>(3, "id", -1.f) == 3.f);
+    EDAT_CHECK(arr.row(2).getOr<bool>("enabled", false) == true);
+
+    // Same keys set in a different order is a different shape as well
+    std::vector<edat::Table> reordered;
+    reordered.push_back(makeItem(0, true));
+    edat::Table backwards;
+    backwards.set<std::string>("name", "item1");
+    backwards.set("enabled", false);
+    backwards.set("weight", 0.5f);
+    backwards.set("id", 1);
+    reordered.push_back(std::move(backwards));
+    const edat::TableArray other = edat::TableArray::fromTables(std::move(reordered));
+    EDAT_CHECK(!other.columnar() && other.size() == 2);
+    EDAT_CHECK(other.getOr<std::string>(1, "name", "") == "item1");
+
+    const edat::TableArray empty = edat::TableArray::fromTables({});
+    EDAT_CHECK(!empty.columnar() && empty.size() == 0);
+    EDAT_CHECK(empty.column<int>("id").empty());
+}
+
+// Elements rebuilt from the columns are standalone tables with the original values
+static void testRows()
+{
+    std::vector<edat::Table> items;
+    for (int i = 0; i < 5; ++i)
+    {
+        edat::Table item = makeItem(i, i % 2 == 0);
+        item.set("gone", 1);
+        item.erase("gone");
+        items.push_back(std::move(item));
+    }
+    const edat::TableArray arr = edat::TableArray::fromTables(std::move(items));
+    EDAT_CHECK(arr.columnar());
+    for (int i = 0; i < 5; ++i)
+    {
+        edat::Table row = arr.row(size_t(i));
+        EDAT_CHECK(row.getOr<int>("id", -1) == i);
+        EDAT_CHECK(row.getOr<float>("weight", -1.f) == float(i) * 0.5f);
+        EDAT_CHECK(row.getOr<bool>("enabled", i % 2 != 0) == (i % 2 == 0));
+        EDAT_CHECK(row.getOr<std::string>("name", "") == "item" + std::to_string(i));
+        EDAT_CHECK(row.getOr<int>("gone", -1) == -1);
+
+        // Changing the copy leaves the array alone
+        row.set("id", 100);
+        row.set("more", 1);
+        EDAT_CHECK(arr.getOr<int>(size_t(i), "id", -1) == i);
+    }
+
+    // Copies of the array own their columns
+    edat::TableArray copy = arr;
+    EDAT_CHECK(copy.columnar() && copy.size() == 5);
+    EDAT_CHECK(copy.column<int>("id").data() != arr.column<int>("id").data());
+    EDAT_CHECK(copy.row(4).getOr<std::string>("name", "") == "item4");
+    edat::TableArray moved = std::move(copy);
+    EDAT_CHECK(moved.size() == 5 && copy.size() == 0);
+    EDAT_CHECK(moved.getOr<int>(3, "id", -1) == 3);
+}
+
+// Arrays of tables in a document end up columnar when the elements match
+static void testParsed()
+{
+    edat::ParserSuite psuite;
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+    const edat::Table tbl = edat::parseString(
+        "same:table[] = [ { a:int = \"1\"; b:int = \"2\" } { a:int = \"3\"; b:int = \"4\" } ]\n"
+        "mixed:table[] = [ { a:int = \"1\" } { b:int = \"2\" } ]\n", psuite);
+    bool found = false;
+    tbl.get<edat::TableArray>("same", [&](const edat::TableArray& arr)
+    {
+        found = true;
+        EDAT_CHECK(arr.columnar() && arr.size() == 2);
+        std::span<const int> col = arr.column<int>("b");
+        EDAT_CHECK(col.size() == 2 && col[0] == 2 && col[1] == 4);
+    });
+    EDAT_CHECK(found);
+    found = false;
+    tbl.get<edat::TableArray>("mixed", [&](const edat::TableArray& arr)
+    {
+        found = true;
+        EDAT_CHECK(!arr.columnar() && arr.size() == 2);
+        EDAT_CHECK(arr.getOr<int>(1, "b", -1) == 2);
+    });
+    EDAT_CHECK(found);
+}
+
+int main()
+{
+    testColumnar();
+    testMixedShapes();
+    testRows();
+    testParsed();
+    return testResult();
+}
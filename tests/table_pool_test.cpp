@@ -0,0 +1,187 @@
+#include <table_pool.h>
+
+#include <atomic>
+#include <thread>
+
+#include "test_common.h"
+
+static void fill(edat::Table& tbl, int seed)
+{
+    for (int i = 0; i < 20; ++i)
+        tbl.set("k" + std::to_string(i), int(seed + i));
+    tbl.set("f", float(seed));
+    tbl.set("flag", true);
+    tbl.set<std::string>("s", "seed" + std::to_string(seed));
+    edat::Table child;
+    child.set("x", int(seed));
+    tbl.set("child", std::move(child));
+}
+
+// Nothing of the old contents is visible, through any of the lookups
+static void checkEmpty(const edat::Table& tbl)
+{
+    EDAT_CHECK(tbl.shape->names.empty());
+    EDAT_CHECK(tbl.shape->records.empty());
+    EDAT_CHECK(tbl.shape->nameMap.empty());
+    for (int i = 0; i < 20; ++i)
+        EDAT_CHECK(tbl.getOr<int>("k" + std::to_string(i), -1) == -1);
+    EDAT_CHECK(tbl.getOr<float>("f", -1.f) == -1.f);
+    EDAT_CHECK(tbl.getOr<bool>("flag", false) == false);
+    EDAT_CHECK(tbl.getOr<std::string>("s", "none") == "none");
+    bool found = false;
+    tbl.get<edat::Table>("child", [&](const edat::Table&) { found = true; });
+    EDAT_CHECK(!found);
+    EDAT_CHECK(tbl.view<int>().size() == 0);
+    EDAT_CHECK(tbl.view<bool>().size() == 0);
+    size_t count = 0;
+    tbl.getAll<int>([&](const std::string&, int) { count++; });
+    EDAT_CHECK(count == 0);
+}
+
+// A cleared table behaves like a new one, reusing names and map nodes for the next keys
+static void testClear()
+{
+    edat::Table tbl;
+    fill(tbl, 0);
+    edat::Handle<int> handle = tbl.handle<int>("k3");
+    EDAT_CHECK(handle.getOr(-1) == 3);
+    tbl.clear();
+    checkEmpty(tbl);
+    EDAT_CHECK(!handle.get());
+    EDAT_CHECK(tbl.spareNames.size() == 24);
+    EDAT_CHECK(tbl.spareNodes.size() == 24);
+
+    // Other keys with other types: no stale names, no stale records
+    tbl.set("k3", 1.5f);
+    tbl.set("other", 7);
+    tbl.set("flag", 2);
+    EDAT_CHECK(tbl.spareNames.size() == 21 && tbl.spareNodes.size() == 21);
+    EDAT_CHECK(tbl.shape->names == (std::vector<std::string>{"k3", "other", "flag"}));
+    EDAT_CHECK(tbl.getOr<int>("k3", -1) == -1);
+    EDAT_CHECK(tbl.getOr<float>("k3", -1.f) == 1.5f);
+    EDAT_CHECK(tbl.getOr<bool>("flag", false) == false);
+    EDAT_CHECK(tbl.getOr<int>("flag", -1) == 2);
+    EDAT_CHECK(tbl.getOr<int>("k4", -1) == -1);
+    EDAT_CHECK(tbl.getOr<int>("other", -1) == 7);
+    EDAT_CHECK(tbl.view<int>().size() == 2);
+    EDAT_CHECK(!handle.get());
+
+    // Erasing and compacting still work on the reused parts
+    tbl.erase("other");
+    tbl.compact();
+    EDAT_CHECK(tbl.shape->names == (std::vector<std::string>{"k3", "flag"}));
+    EDAT_CHECK(tbl.getOr<int>("flag", -1) == 2);
+}
+
+// Clearing a table whose shape is shared must leave the other tables alone
+static void testClearShared()
+{
+    edat::Table tbl;
+    fill(tbl, 10);
+    edat::Table copy = edat::cloneTable(tbl);
+    EDAT_CHECK(copy.shape == tbl.shape);
+    const std::shared_ptr<edat::Shape> before = tbl.shape;
+
+    tbl.clear();
+    checkEmpty(tbl);
+    EDAT_CHECK(tbl.shape != before);
+    EDAT_CHECK(copy.shape == before);
+    EDAT_CHECK(copy.getOr<int>("k19", -1) == 29);
+    EDAT_CHECK(copy.getOr<std::string>("s", "") == "seed10");
+
+    // Refilled with the same keys, still separate from the copy
+    fill(tbl, 20);
+    tbl.set("extra", 1);
+    EDAT_CHECK(tbl.shape != copy.shape);
+    EDAT_CHECK(tbl.getOr<int>("k0", -1) == 20);
+    EDAT_CHECK(copy.getOr<int>("k0", -1) == 10);
+    EDAT_CHECK(copy.getOr<int>("extra", -1) == -1);
+    EDAT_CHECK(copy.shape->names.size() == 24);
+
+    // And the other way around: the copy cleared, the original keeps its values
+    copy.clear();
+    checkEmpty(copy);
+    EDAT_CHECK(tbl.getOr<int>("k19", -1) == 39);
+    EDAT_CHECK(tbl.getOr<int>("extra", -1) == 1);
+}
+
+static void testPool()
+{
+    edat::TablePool pool(2, 16);
+    EDAT_CHECK(pool.available() == 2);
+    const edat::Table* first = nullptr;
+    {
+        edat::TablePool::Lease lease = pool.acquire();
+        EDAT_CHECK(pool.available() == 1);
+        checkEmpty(*lease);
+        EDAT_CHECK(lease->shape->records.capacity() >= 16);
+        fill(*lease, 1);
+        first = lease.table.get();
+    }
+    EDAT_CHECK(pool.available() == 2);
+
+    // The released table comes back cleared
+    edat::TablePool::Lease lease = pool.acquire();
+    EDAT_CHECK(lease.table.get() == first);
+    checkEmpty(*lease);
+    fill(*lease, 2);
+    EDAT_CHECK(lease->getOr<int>("k1", -1) == 3);
+    EDAT_CHECK(lease->spareNames.empty());
+
+    // Moving a lease hands over the table, it's only returned once
+    edat::TablePool::Lease moved = std::move(lease);
+    EDAT_CHECK(!lease.table && moved.table.get() == first);
+    lease.release();
+    EDAT_CHECK(pool.available() == 1);
+    edat::TablePool::Lease other = pool.acquire();
+    EDAT_CHECK(pool.available() == 0);
+    other = std::move(moved);
+    EDAT_CHECK(pool.available() == 1);
+    other.release();
+    EDAT_CHECK(pool.available() == 2);
+
+    // A dry pool makes new tables, all of them end up in the pool
+    {
+        std::vector<edat::TablePool::Lease> leases;
+        for (int i = 0; i < 4; ++i)
+            leases.push_back(pool.acquire());
+        EDAT_CHECK(pool.available() == 0);
+    }
+    EDAT_CHECK(pool.available() == 4);
+}
+
+// Every lease starts empty and belongs to one thread only
+static void testPoolThreads()
+{
+    edat::TablePool pool(2);
+    std::atomic<int> failures = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&pool, &failures, t]()
+        {
+            for (int i = 0; i < 200; ++i)
+            {
+                edat::TablePool::Lease lease = pool.acquire();
+                if (!lease->shape->names.empty() || lease->getOr<int>("k0", -1) != -1)
+                    failures++;
+                fill(*lease, t * 1000 + i);
+                if (lease->getOr<int>("k5", -1) != t * 1000 + i + 5)
+                    failures++;
+            }
+        });
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+    EDAT_CHECK(failures == 0);
+    EDAT_CHECK(pool.available() >= 2 && pool.available() <= 4);
+}
+
+int main()
+{
+    testClear();
+    testClearShared();
+    testPool();
+    testPoolThreads();
+    return testResult();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+// Minimal checks for the tests: failures are reported and counted, main returns testResult().
+// Unlike assert these stay on in release builds.
+inline int& testFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define EDAT_CHECK(cond)                                                            \
+    do                                                                              \
+    {                                                                               \
+        if (!(cond))                                                                \
+        {                                                                           \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond);         \
+            testFailures()++;                                                       \
+        }                                                                           \
+    } while (0)
+
+inline int testResult()
+{
+    if (testFailures() != 0)
+        printf("%d check(s) failed\n", testFailures());
+    return testFailures() != 0 ? 1 : 0;
+}
+
+// Fresh empty directory for a test's files, under the system temp directory
+inline std::filesystem::path testDirectory(const std::string& name)
+{
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / ("edat_test_" + name);
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    return dir;
+}
+
+inline void writeTextFile(const std::filesystem::path& path, const std::string& contents)
+{
+    FILE* file = fopen(path.string().c_str(), "wb");
+    if (!file)
+        return;
+    fwrite(contents.data(), 1, contents.size(), file);
+    fclose(file);
+}
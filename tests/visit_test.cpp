@@ -0,0 +1,115 @@
+#include <visit.h>
+
+#include "test_common.h"
+
+enum class Mode : uint8_t { Off, On };
+
+struct Custom
+{
+    int value = 0;
+};
+
+// Name and visited type of every entry, in the order the visitor got them
+using Visited = std::vector<std::pair<std::string, std::string>>;
+
+static void testInsertionOrder()
+{
+    edat::Table tbl;
+    tbl.set("z", 1);
+    tbl.set("a", 2.f);
+    tbl.set("m", true);
+    tbl.set<std::string>("b", "text");
+    tbl.set("y", 3);
+    tbl.erase("a");
+    tbl.set("a", 4.f);
+
+    Visited visited;
+    edat::visit(tbl, edat::overloaded{
+        [&](const std::string& name, int) { visited.emplace_back(name, "int"); },
+        [&](const std::string& name, float) { visited.emplace_back(name, "float"); },
+        [&](const std::string& name, bool) { visited.emplace_back(name, "bool"); },
+        [&](const std::string& name, const std::string&) { visited.emplace_back(name, "string"); },
+        [&](const std::string& name, const edat::UnknownValue&) { visited.emplace_back(name, "unknown"); }
+    });
+    EDAT_CHECK(visited == Visited({{"z", "int"}, {"m", "bool"}, {"b", "string"}, {"y", "int"}, {"a", "float"}}));
+}
+
+// Values only reach an overload for exactly their type, conversions would hand ints to a float overload
+// and bools to an int one
+static void testExactTypes()
+{
+    edat::Table tbl;
+    tbl.set("i", 1);
+    tbl.set("f", 2.f);
+    tbl.set("b", true);
+
+    Visited floatsOnly;
+    edat::visit(tbl, edat::overloaded{
+        [&](const std::string& name, float) { floatsOnly.emplace_back(name, "float"); },
+        [&](const std::string& name, const edat::UnknownValue& val)
+        {
+            floatsOnly.emplace_back(name, val.type == typeid(int) ? "unknown int" : val.type == typeid(bool) ? "unknown bool" : "?");
+        }
+    });
+    EDAT_CHECK(floatsOnly == Visited({{"i", "unknown int"}, {"f", "float"}, {"b", "unknown bool"}}));
+
+    Visited numbers;
+    edat::visit(tbl, edat::overloaded{
+        [&](const std::string& name, const int&) { numbers.emplace_back(name, "int"); },
+        [&](const std::string& name, float) { numbers.emplace_back(name, "float"); },
+        [&](const std::string& name, const edat::UnknownValue&) { numbers.emplace_back(name, "unknown"); }
+    });
+    EDAT_CHECK(numbers == Visited({{"i", "int"}, {"f", "float"}, {"b", "unknown"}}));
+
+    // Without an UnknownValue overload the rest is skipped
+    int ints = 0;
+    edat::visit(tbl, [&](const std::string&, int val) { ints += val; });
+    EDAT_CHECK(ints == 1);
+}
+
+// Types added along the way are in the defaults, user types (enums) can be appended
+static void testTypeLists()
+{
+    edat::Table tbl;
+    edat::FixedArray<float> grid;
+    grid.rank = 2;
+    grid.extents = {2, 2};
+    grid.data = {1.f, 2.f, 3.f, 4.f};
+    tbl.set("grid", std::move(grid));
+    edat::Table row;
+    row.set("x", 1);
+    std::vector<edat::Table> rows;
+    rows.push_back(std::move(row));
+    tbl.set("rows", edat::TableArray::fromTables(std::move(rows)));
+    tbl.set("mode", Mode::On);
+    tbl.set("custom", Custom{5});
+
+    auto visitor = [](Visited& visited)
+    {
+        return edat::overloaded{
+            [&](const std::string& name, const edat::FixedArray<float>& val) { visited.emplace_back(name, "grid " + std::to_string(val(1, 0))); },
+            [&](const std::string& name, const edat::TableArray& val) { visited.emplace_back(name, "rows " + std::to_string(val.size())); },
+            [&](const std::string& name, Mode val) { visited.emplace_back(name, val == Mode::On ? "on" : "off"); },
+            [&](const std::string& name, const edat::UnknownValue& val)
+            {
+                EDAT_CHECK(val.type == typeid(Mode) || val.type == typeid(Custom));
+                visited.emplace_back(name, "unknown");
+            }
+        };
+    };
+    Visited defaults;
+    edat::visit(tbl, visitor(defaults));
+    EDAT_CHECK(defaults == Visited({{"grid", "grid 3.000000"}, {"rows", "rows 1"}, {"mode", "unknown"}, {"custom", "unknown"}}));
+
+    Visited withEnum;
+    edat::visit<edat::VisitTypesWith<Mode>>(tbl, visitor(withEnum));
+    EDAT_CHECK(withEnum == Visited({{"grid", "grid 3.000000"}, {"rows", "rows 1"}, {"mode", "on"}, {"custom", "unknown"}}));
+}
+
+int main()
+{
+    testInsertionOrder();
+    testExactTypes();
+    testTypeLists();
+    return testResult();
+}
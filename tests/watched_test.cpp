@@ -0,0 +1,142 @@
+#include <watched.h>
+
+#include <charconv>
+#include <functional>
+#include <thread>
+
+#include "test_common.h"
+
+namespace fs = std::filesystem;
+
+static void setupParsers(edat::ParserSuite& psuite)
+{
+    psuite.addLambdaParser<int>("int", [](const std::string_view& str) -> int
+    {
+        int res = 0;
+        std::from_chars(str.data(), str.data() + str.size(), res);
+        return res;
+    });
+}
+
+static std::string document(int value)
+{
+    return "value:int = \"" + std::to_string(value) + "\"\n";
+}
+
+// Written next to it and renamed over it, so the watcher never sees a half written file
+static void replaceFile(const fs::path& path, const std::string& contents)
+{
+    fs::path tmp = path;
+    tmp += ".tmp";
+    writeTextFile(tmp, contents);
+    fs::rename(tmp, path);
+}
+
+static bool waitFor(std::function<bool()> cond)
+{
+    for (int i = 0; i < 500; ++i)
+    {
+        if (cond())
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Readers hammer get() while versions are published back to back (by reload() here and by the watcher
+// noticing the writes), retired versions have to stay bounded
+static void testReloadUnderLoad(const edat::ParserSuite& psuite)
+{
+    const fs::path dir = testDirectory("watched_load");
+    const fs::path path = dir / "load.edat";
+    writeTextFile(path, document(0));
+    edat::Watched watched({path}, psuite, std::chrono::milliseconds(10));
+
+    constexpr int versions = 200;
+    std::atomic<bool> stop = false;
+    std::atomic<int> readerFailures = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t)
+    {
+        readers.emplace_back([&]()
+        {
+            while (!stop.load())
+            {
+                edat::Snapshot snapshot = watched.get(0);
+                int value = snapshot.getOr<int>("value", -1);
+                if (value < 0 || value > versions)
+                    readerFailures++;
+            }
+        });
+    }
+
+    size_t maxRetired = 0;
+    for (int i = 1; i <= versions; ++i)
+    {
+        replaceFile(path, document(i));
+        EDAT_CHECK(watched.reload(0));
+        std::lock_guard<std::mutex> lock(watched.publishMutex);
+        maxRetired = std::max(maxRetired, watched.retired.size());
+    }
+    stop = true;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    EDAT_CHECK(readerFailures == 0);
+    EDAT_CHECK(maxRetired <= edat::Watched::hazardSlots);
+    // The watcher may still publish a version it started reading before the last reload, it catches up after
+    EDAT_CHECK(waitFor([&]() { return watched.get(0).getOr<int>("value", -1) == versions; }));
+    fs::remove_all(dir);
+}
+
+// Two watched files with the same name in different directories, only the edited one reloads
+static void testSameNameInTwoDirectories(const edat::ParserSuite& psuite)
+{
+    const fs::path dir = testDirectory("watched_dirs");
+    fs::create_directories(dir / "a");
+    fs::create_directories(dir / "b");
+    writeTextFile(dir / "a" / "conf.edat", document(1));
+    writeTextFile(dir / "b" / "conf.edat", document(2));
+    edat::Watched watched({dir / "a" / "conf.edat", dir / "b" / "conf.edat"}, psuite, std::chrono::milliseconds(10));
+    EDAT_CHECK(watched.get(0).getOr<int>("value", -1) == 1);
+    EDAT_CHECK(watched.get(1).getOr<int>("value", -1) == 2);
+
+    const uint64_t otherGeneration = watched.generation(1);
+    replaceFile(dir / "a" / "conf.edat", document(10));
+    EDAT_CHECK(waitFor([&]() { return watched.get(0).getOr<int>("value", -1) == 10; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    EDAT_CHECK(watched.generation(1) == otherGeneration);
+    EDAT_CHECK(watched.get(1).getOr<int>("value", -1) == 2);
+    fs::remove_all(dir);
+}
+
+// An edit with errors (here a truncated table) is reported and the good version stays published
+static void testBrokenEdit(const edat::ParserSuite& psuite)
+{
+    const fs::path dir = testDirectory("watched_broken");
+    const fs::path path = dir / "config.edat";
+    writeTextFile(path, document(1));
+    edat::Watched watched({path}, psuite, std::chrono::milliseconds(10));
+    EDAT_CHECK(watched.get(0).getOr<int>("value", -1) == 1);
+
+    const uint64_t generation = watched.generation(0);
+    replaceFile(path, document(2) + "sub = {\n    inner:int = \"3\"\n");
+    EDAT_CHECK(!watched.reload(0));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50)); // the watcher's reload fails the same way
+    EDAT_CHECK(watched.get(0).getOr<int>("value", -1) == 1);
+    EDAT_CHECK(watched.generation(0) == generation);
+
+    replaceFile(path, document(4));
+    EDAT_CHECK(waitFor([&]() { return watched.get(0).getOr<int>("value", -1) == 4; }));
+    fs::remove_all(dir);
+}
+
+int main()
+{
+    edat::ParserSuite psuite;
+    setupParsers(psuite);
+    testReloadUnderLoad(psuite);
+    testSameNameInTwoDirectories(psuite);
+    testBrokenEdit(psuite);
+    return testResult();
+}
@@ -0,0 +1,95 @@
+#include "generator.h"
+
+#include <cstdlib>
+#include <cstring>
+
+// Command line front end for the synthetic document generator.
+// Usage: edat_gen [options] [--out file.edat]   (stdout if no --out)
+//   --seed N            PRNG seed (1)
+//   --size N[K|M|G]     stop after this many bytes (1M)
+//   --keys N            stop after this many top level entries (unlimited)
+//   --table-keys N      entries per nested table (8)
+//   --depth N           maximum table nesting (2)
+//   --inherit N         length of `<-` inheritance chains between sibling tables (0, off)
+//   --arrays MIN:MAX    array lengths (1:8)
+//   --strings MIN:MAX   string lengths (4:32)
+//   --mix I,F,S,A,T     weights of int, float, string, array and table values (4,4,2,1,1)
+
+static uint64_t parseSize(const char* str)
+{
+    char* end = nullptr;
+    uint64_t res = strtoull(str, &end, 10);
+    switch (*end)
+    {
+    case 'k': case 'K': return res << 10;
+    case 'm': case 'M': return res << 20;
+    case 'g': case 'G': return res << 30;
+    default: return res;
+    }
+}
+
+static bool parseRange(const char* str, size_t& lo, size_t& hi)
+{
+    unsigned long long a = 0, b = 0;
+    if (sscanf(str, "%llu:%llu", &a, &b) != 2 || a > b)
+        return false;
+    lo = size_t(a);
+    hi = size_t(b);
+    return true;
+}
+
+int main(int argc, const char** argv)
+{
+    edat::GeneratorConfig config;
+    const char* outPath = nullptr;
+    bool keysGiven = false;
+    bool sizeGiven = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = i + 1 < argc;
+        if (!strcmp(argv[i], "--seed") && hasValue)
+            config.seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--size") && hasValue)
+        {
+            config.targetBytes = parseSize(argv[++i]);
+            sizeGiven = true;
+        }
+        else if (!strcmp(argv[i], "--keys") && hasValue)
+        {
+            config.keyCount = strtoull(argv[++i], nullptr, 10);
+            keysGiven = true;
+        }
+        else if (!strcmp(argv[i], "--table-keys") && hasValue)
+            config.keysPerTable = size_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--depth") && hasValue)
+            config.maxDepth = size_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--inherit") && hasValue)
+            config.inheritanceChain = size_t(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--arrays") && hasValue && parseRange(argv[i + 1], config.minArrayLength, config.maxArrayLength))
+            ++i;
+        else if (!strcmp(argv[i], "--strings") && hasValue && parseRange(argv[i + 1], config.minStringLength, config.maxStringLength))
+            ++i;
+        else if (!strcmp(argv[i], "--mix") && hasValue &&
+                 sscanf(argv[i + 1], "%u,%u,%u,%u,%u", &config.intWeight, &config.floatWeight, &config.stringWeight,
+                        &config.arrayWeight, &config.tableWeight) == 5)
+            ++i;
+        else if (!strcmp(argv[i], "--out") && hasValue)
+            outPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--seed N] [--size N[K|M|G]] [--keys N] [--table-keys N] [--depth N] [--inherit N]\n"
+                            "       [--arrays MIN:MAX] [--strings MIN:MAX] [--mix I,F,S,A,T] [--out file]\n", argv[0]);
+            return 1;
+        }
+    }
+    // Only the key count limits the document if it was given without a size
+    if (keysGiven && !sizeGiven)
+        config.targetBytes = 0;
+
+    if (outPath)
+        return edat::generateFile(config, outPath) ? 0 : 1;
+
+    edat::generateDocument(config, [](std::string_view chunk) { fwrite(chunk.data(), 1, chunk.size(), stdout); });
+    return 0;
+}
@@ -0,0 +1,237 @@
+#include "generator.h"
+
+#include <vector>
+
+namespace edat
+{
+
+// splitmix64, tiny and good enough for test data
+struct Rng
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        return z ^ (z >> 31);
+    }
+
+    // [lo, hi]
+    uint64_t range(uint64_t lo, uint64_t hi)
+    {
+        if (hi <= lo)
+            return lo;
+        return lo + next() % (hi - lo + 1);
+    }
+};
+
+enum class ValueKind
+{
+    Int,
+    Float,
+    String,
+    Array,
+    Table
+};
+
+struct DocumentWriter
+{
+    const GeneratorConfig& config;
+    const std::function<void(std::string_view)>& out;
+    Rng rng;
+    std::string buffer;
+    uint64_t written = 0;
+    char scratch[64];
+
+    DocumentWriter(const GeneratorConfig& config, const std::function<void(std::string_view)>& out)
+        : config(config), out(out), rng{config.seed}
+    {
+        buffer.reserve(1 << 16);
+    }
+
+    void emit(std::string_view str)
+    {
+        buffer += str;
+        written += str.size();
+        if (buffer.size() >= (1 << 16))
+            flush();
+    }
+
+    void flush()
+    {
+        if (!buffer.empty())
+            out(buffer);
+        buffer.clear();
+    }
+
+    void indent(size_t depth)
+    {
+        for (size_t i = 0; i < depth; ++i)
+            emit("    ");
+    }
+
+    ValueKind pickKind(size_t depth)
+    {
+        const unsigned tableWeight = depth < config.maxDepth ? config.tableWeight : 0;
+        const unsigned total = config.intWeight + config.floatWeight + config.stringWeight + config.arrayWeight + tableWeight;
+        if (total == 0)
+            return ValueKind::Int;
+        uint64_t pick = rng.next() % total;
+        if (pick < config.intWeight)
+            return ValueKind::Int;
+        pick -= config.intWeight;
+        if (pick < config.floatWeight)
+            return ValueKind::Float;
+        pick -= config.floatWeight;
+        if (pick < config.stringWeight)
+            return ValueKind::String;
+        pick -= config.stringWeight;
+        if (pick < config.arrayWeight)
+            return ValueKind::Array;
+        return ValueKind::Table;
+    }
+
+    void emitInt()
+    {
+        snprintf(scratch, sizeof(scratch), "\"%lld\"", (long long)(rng.next() % 2000001) - 1000000);
+        emit(scratch);
+    }
+
+    void emitFloat()
+    {
+        snprintf(scratch, sizeof(scratch), "\"%.3f\"", double(int64_t(rng.next() % 2000001) - 1000000) / 64.0);
+        emit(scratch);
+    }
+
+    void emitString()
+    {
+        static constexpr char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 _-";
+        const size_t length = rng.range(config.minStringLength, config.maxStringLength);
+        emit("\"");
+        for (size_t i = 0; i < length; ++i)
+        {
+            char ch = alphabet[rng.next() % (sizeof(alphabet) - 1)];
+            emit(std::string_view(&ch, 1));
+        }
+        emit("\"");
+    }
+
+    void emitEntry(size_t depth, size_t idx, std::vector<std::string>& siblingTables)
+    {
+        indent(depth);
+        snprintf(scratch, sizeof(scratch), "key_%zu", idx);
+        const std::string name = scratch;
+        switch (pickKind(depth))
+        {
+        case ValueKind::Int:
+            emit(name);
+            emit(":int = ");
+            emitInt();
+            break;
+        case ValueKind::Float:
+            emit(name);
+            emit(":float = ");
+            emitFloat();
+            break;
+        case ValueKind::String:
+            emit(name);
+            emit(":str = ");
+            emitString();
+            break;
+        case ValueKind::Array:
+        {
+            const unsigned elementKind = unsigned(rng.next() % 3);
+            const size_t length = rng.range(config.minArrayLength, config.maxArrayLength);
+            emit(name);
+            emit(elementKind == 0 ? ":int[] = [ " : elementKind == 1 ? ":float[] = [ " : ":str[] = [ ");
+            for (size_t i = 0; i < length; ++i)
+            {
+                if (i > 0)
+                    emit(", ");
+                if (elementKind == 0)
+                    emitInt();
+                else if (elementKind == 1)
+                    emitFloat();
+                else
+                    emitString();
+            }
+            emit(" ]");
+            break;
+        }
+        case ValueKind::Table:
+        {
+            emit(name);
+            // Chains of inheritance: every table continues the chain of the previous sibling until it's long enough
+            if (config.inheritanceChain > 0 && !siblingTables.empty() && siblingTables.size() % (config.inheritanceChain + 1) != 0)
+            {
+                emit(" <- ");
+                emit(siblingTables.back());
+            }
+            emit(" = {\n");
+            emitTable(depth + 1, config.keysPerTable);
+            indent(depth);
+            emit("}");
+            siblingTables.push_back(name);
+            break;
+        }
+        }
+        emit("\n");
+    }
+
+    void emitTable(size_t depth, uint64_t count)
+    {
+        std::vector<std::string> siblingTables;
+        for (uint64_t i = 0; i < count; ++i)
+            emitEntry(depth, size_t(i), siblingTables);
+    }
+
+    void emitDocument()
+    {
+        std::vector<std::string> siblingTables;
+        for (uint64_t i = 0; ; ++i)
+        {
+            if (config.keyCount > 0 && i >= config.keyCount)
+                break;
+            if (config.targetBytes > 0 && written >= config.targetBytes)
+                break;
+            if (config.keyCount == 0 && config.targetBytes == 0)
+                break;
+            emitEntry(0, size_t(i), siblingTables);
+        }
+        flush();
+    }
+};
+
+void generateDocument(const GeneratorConfig& config, const std::function<void(std::string_view)>& out)
+{
+    DocumentWriter writer(config, out);
+    writer.emitDocument();
+}
+
+std::string generateString(const GeneratorConfig& config)
+{
+    std::string res;
+    generateDocument(config, [&](std::string_view chunk) { res += chunk; });
+    return res;
+}
+
+bool generateFile(const GeneratorConfig& config, const std::string& path)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f)
+    {
+        printf("Error: can't open '%s' for writing\n", path.c_str());
+        return false;
+    }
+    bool ok = true;
+    generateDocument(config, [&](std::string_view chunk)
+    {
+        ok &= fwrite(chunk.data(), 1, chunk.size(), f) == chunk.size();
+    });
+    fclose(f);
+    return ok;
+}
+
+}
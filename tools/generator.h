@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace edat
+{
+
+// Parameters of a synthetic .edat document. Output only depends on these (the PRNG is our own,
+// not <random>), so the same config produces byte-identical documents on every platform.
+struct GeneratorConfig
+{
+    uint64_t seed = 1;
+
+    // Generation stops once either limit is hit, 0 disables a limit (not both)
+    uint64_t targetBytes = 1 << 20;
+    uint64_t keyCount = 0; // top level entries
+
+    size_t keysPerTable = 8;     // entries in every nested table
+    size_t maxDepth = 2;         // nesting depth of tables
+    size_t inheritanceChain = 0; // sibling tables inherit (`<-`) from the previous one in chains of this length
+
+    size_t minArrayLength = 1;
+    size_t maxArrayLength = 8;
+    size_t minStringLength = 4;
+    size_t maxStringLength = 32;
+
+    // Relative weights of the generated value kinds
+    unsigned intWeight = 4;
+    unsigned floatWeight = 4;
+    unsigned stringWeight = 2;
+    unsigned arrayWeight = 1;
+    unsigned tableWeight = 1;
+};
+
+// Streams the document out in chunks, so multi-GB documents don't need to fit in memory
+void generateDocument(const GeneratorConfig& config, const std::function<void(std::string_view)>& out);
+
+std::string generateString(const GeneratorConfig& config);
+bool generateFile(const GeneratorConfig& config, const std::string& path);
+
+}